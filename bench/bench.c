@@ -0,0 +1,559 @@
+/***********************************
+   bench.c, @format.new-line  lf
+            @format.use-tabs  false
+   @format.tab-size    2
+   @format.indent-size 2
+   @format.line-length 80
+************************************/
+/* clock_gettime, dup and dup2 are POSIX, not ANSI. */
+#define _POSIX_C_SOURCE 199309L
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "config.h"
+#include "io.h"
+#include "tokenizer.h"
+#include "program.h"
+#include "vvtbi.h"
+
+/* Batches run, untimed, before measuring. */
+#define BENCH_WARMUP  3
+
+/* Batches timed per benchmark. */
+#define BENCH_SAMPLES 15
+
+/* The input of the tokenizer and io benchmarks, in bytes. */
+#define BENCH_INPUT   (1 << 20)
+
+/* A batch of a benchmark; returns the amount of operations run. */
+typedef unsigned long (*batch) (void);
+
+/* The input of the tokenizer and io benchmarks. */
+static char *input = NULL;
+
+/* The length of input. */
+static size_t input_size = 0;
+
+/* The program of the evaluator benchmarks. */
+static struct vvtbi_context context;
+
+/* The program of the line-table benchmarks. */
+static struct program *lines = NULL;
+
+/* The amount of lines in lines. */
+static size_t line_count = 0;
+
+/* The step between the line numbers of lines. */
+static int line_step = 10;
+
+/* The array elements, or loop iterations, a run of the array
+   and typed benchmarks touches. */
+#define BENCH_ELEMENTS 1000
+
+/* Keeps results alive, so the compiler can't remove the work. */
+static volatile long sink = 0;
+
+/* Separates benchmarks in the JSON output. */
+static const char *comma = "";
+
+/* The JSON output; a copy of stdout, as PRINT's stdout is muted. */
+static FILE *results = NULL;
+
+/******************************************************************************/
+
+/**
+ * now
+ *
+ * @param void
+ * @return The monotonic clock, in nanoseconds.
+ */
+
+static double now (void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+/**
+ * measure
+ *
+ * @param name The benchmark's name.
+ * @param run A batch of the benchmark.
+ * @return void
+ */
+
+static void measure (const char *name, batch run)
+{
+  double        sample[BENCH_SAMPLES], start, mean, variance, min;
+  unsigned long ops;
+  int           i;
+
+  for (i = 0; i < BENCH_WARMUP; i++)
+    run();
+  for (i = 0, mean = 0, min = -1; i < BENCH_SAMPLES; i++)
+  {
+    start     = now();
+    ops       = run();
+    sample[i] = (now() - start) / (ops ? ops : 1);
+    mean     += sample[i];
+    if (min < 0 || sample[i] < min)
+      min = sample[i];
+  }
+  mean /= BENCH_SAMPLES;
+  for (i = 0, variance = 0; i < BENCH_SAMPLES; i++)
+    variance += (sample[i] - mean) * (sample[i] - mean);
+  variance /= BENCH_SAMPLES - 1;
+  fprintf(results, "%s\n    {\"name\": \"%s\", \"ns_per_op\": %.3f, "
+    "\"stddev\": %.3f, \"min\": %.3f, \"ops\": %lu, "
+    "\"samples\": %d}",
+    comma, name, mean, sqrt(variance), min, ops, BENCH_SAMPLES);
+  comma = ",";
+  fflush(results);
+}
+
+/**
+ * repeat
+ *
+ * @param pattern Source text to repeat.
+ * @return void
+ */
+
+static void repeat (const char *pattern)
+{
+  size_t n;
+  n = strlen(pattern);
+  free(input);
+  input      = malloc(BENCH_INPUT + 1);
+  input_size = 0;
+  while (input && input_size + n <= BENCH_INPUT)
+  {
+    memcpy(input + input_size, pattern, n);
+    input_size += n;
+  }
+  if (!input)
+  {
+    fprintf(stderr, "*bench.c: out of memory!\n");
+    exit(EXIT_FAILURE);
+  }
+  input[input_size] = 0;
+}
+
+/**
+ * compile
+ *
+ * @param source Source code.
+ * @return The compiled program.
+ */
+
+static struct program *compile (const char *source)
+{
+  char  *copy;
+  size_t n;
+  n    = strlen(source);
+  copy = malloc(n + 1);
+  if (!copy)
+  {
+    fprintf(stderr, "*bench.c: out of memory!\n");
+    exit(EXIT_FAILURE);
+  }
+  memcpy(copy, source, n + 1);
+  return program_compile("bench", copy, n);
+}
+
+/**
+ * batch_tokenizer
+ *
+ * @param void
+ * @return ops The amount of tokens scanned.
+ */
+
+static unsigned long batch_tokenizer (void)
+{
+  unsigned long ops;
+  tokenizer_buffer("bench", input, input_size);
+  for (ops = 1; !tokenizer_finished(); ops++)
+  {
+    sink += tokenizer_token();
+    tokenizer_next();
+  }
+  return ops;
+}
+
+/**
+ * batch_io
+ *
+ * @param void
+ * @return ops The amount of characters read.
+ */
+
+static unsigned long batch_io (void)
+{
+  unsigned long ops;
+  io_buffer("bench", input, input_size);
+  for (ops = 0; !io_eof(); ops++)
+  {
+    sink += io_current();
+    io_next();
+  }
+  return ops;
+}
+
+/**
+ * batch_statement
+ *
+ * @param void
+ * @return ops The amount of times the first line was run.
+ */
+
+static unsigned long batch_statement (void)
+{
+  struct vvtbi_context c;
+  unsigned long        ops;
+  for (ops = 0; ops < 100000; ops++)
+  {
+    c = context;
+    vvtbi_step(&c, 1);
+    sink += c.variables[0];
+  }
+  return ops;
+}
+
+/**
+ * batch_program
+ *
+ * @param void
+ * @return ops The amount of array elements, or iterations, run.
+ */
+
+static unsigned long batch_program (void)
+{
+  struct vvtbi_context c;
+  unsigned long        ops;
+  for (ops = 0; ops < 100 * BENCH_ELEMENTS; ops += BENCH_ELEMENTS)
+  {
+    /* Run it from the start, over the same arrays. */
+    c = context;
+    while (!c.finished)
+      vvtbi_step(&c, BENCH_ELEMENTS);
+    sink += c.variables[program_variable(c.program, "s")];
+  }
+  return ops;
+}
+
+/**
+ * batch_lines
+ *
+ * @param void
+ * @return ops The amount of line numbers found.
+ */
+
+static unsigned long batch_lines (void)
+{
+  unsigned long ops, seed;
+  for (ops = 0, seed = 1; ops < 100000; ops++)
+  {
+    /* Any line number, from a linear congruential generator. */
+    seed  = (seed * 1103515245UL + 12345UL) & 0x7fffffffUL;
+    sink += program_find(lines,
+      (int) (seed % line_count + 1) * line_step);
+  }
+  return ops;
+}
+
+/**
+ * bench_tokenizer
+ *
+ * @param name The benchmark's name.
+ * @param pattern Source text of one token class, to repeat.
+ * @return void
+ */
+
+static void bench_tokenizer (const char *name, const char *pattern)
+{
+  repeat(pattern);
+  measure(name, batch_tokenizer);
+}
+
+/**
+ * bench_statement
+ *
+ * @param name The benchmark's name.
+ * @param source A program; its first line is measured.
+ * @return void
+ */
+
+static void bench_statement (const char *name, const char *source)
+{
+  vvtbi_attach(&context, compile(source));
+  measure(name, batch_statement);
+  vvtbi_release(&context);
+}
+
+/**
+ * bench_expression
+ *
+ * @param depth The depth of parentheses to nest.
+ * @return void
+ */
+
+static void bench_expression (int depth)
+{
+  char  *source, name[64];
+  size_t n;
+  int    i;
+  source = malloc(16 + depth * 8);
+  if (!source)
+    return;
+  strcpy(source, "10 LET a = ");
+  n = strlen(source);
+  for (i = 0; i < depth; i++)
+    source[n++] = '(';
+  source[n++] = '1';
+  for (i = 0; i < depth; i++)
+  {
+    memcpy(source + n, " + 1)", 5);
+    n += 5;
+  }
+  strcpy(source + n, "\n");
+  sprintf(name, "expression_depth_%d", depth);
+  bench_statement(name, source);
+  free(source);
+}
+
+/**
+ * bench_lines
+ *
+ * @param count The amount of lines in the program.
+ * @param step The step between line numbers: the line table is
+ *             mapped directly up to VVTBI_LINE_SPAN, else searched.
+ * @return void
+ */
+
+static void bench_lines (size_t count, int step)
+{
+  char  *source, name[64];
+  size_t i, n;
+  source = malloc(count * 32 + 1);
+  if (!source)
+    return;
+  for (i = 0, n = 0; i < count; i++)
+    n += sprintf(source + n, "%lu REM\n",
+      (unsigned long) (i + 1) * step);
+  lines      = program_compile("bench", source, n);
+  line_count = count;
+  line_step  = step;
+  sprintf(name, "find_linenum_%lu_step_%d", (unsigned long) count, step);
+  measure(name, batch_lines);
+  program_release(lines);
+}
+
+/**
+ * bench_array
+ *
+ * @param name The benchmark's name.
+ * @param source A program touching BENCH_ELEMENTS array elements.
+ * @return void
+ */
+
+static void bench_array (const char *name, const char *source)
+{
+  vvtbi_attach(&context, compile(source));
+  measure(name, batch_program);
+  vvtbi_release(&context);
+}
+
+/**
+ * bench_typed
+ *
+ * @param name The benchmark's name.
+ * @param source A program of BENCH_ELEMENTS loop iterations.
+ * @param wide Run it with every variable 64-bit, as -int64 does?
+ * @return void
+ */
+
+static void bench_typed (const char *name, const char *source, int wide)
+{
+  program_wide = wide;
+  vvtbi_attach(&context, compile(source));
+  program_wide = 0;
+  measure(name, batch_program);
+  vvtbi_release(&context);
+}
+
+/**
+ * twice
+ *
+ * @param ctx The context calling.
+ * @param args Its one argument.
+ * @return The argument, doubled.
+ */
+
+static int twice (struct vvtbi_context *ctx, const int *args)
+{
+  (void) ctx;
+  return args[0] * 2;
+}
+
+/**
+ * bench_call
+ *
+ * @param void
+ * @return void
+ */
+
+static void bench_call (void)
+{
+  vvtbi_attach(&context, compile(
+    "10 FOR i = 1 TO 1000\n20 s = s + CALL twice(i)\n30 NEXT i\n"));
+  vvtbi_register(&context, "twice", twice, 1);
+  measure("call_host", batch_program);
+  vvtbi_release(&context);
+}
+
+/**
+ * bench_read
+ *
+ * @param void
+ * @return void
+ */
+
+static void bench_read (void)
+{
+  char  *source, *c;
+  size_t i;
+  source = malloc(16 * BENCH_ELEMENTS + 64);
+  if (!source)
+    return;
+  c = source + sprintf(source, "10 FOR i = 1 TO %d\n20 READ x\n"
+    "30 s = s + x\n40 NEXT i\n50 DATA 0", BENCH_ELEMENTS);
+  for (i = 1; i < BENCH_ELEMENTS; i++)
+    c += sprintf(c, ", %lu", (unsigned long) i);
+  strcpy(c, "\n");
+  vvtbi_attach(&context, compile(source));
+  measure("read_data", batch_program);
+  vvtbi_release(&context);
+  free(source);
+}
+
+/**
+ * bench_print
+ *
+ * @param void
+ * @return void
+ */
+
+static void bench_print (void)
+{
+  int saved, null;
+  /* PRINT's own output goes nowhere; the results have their own copy
+     of stdout. */
+  fflush(stdout);
+  saved = dup(1);
+  null  = open("/dev/null", O_WRONLY);
+  if (saved < 0 || null < 0)
+    return;
+  vvtbi_attach(&context, compile("10 PRINT \"value\", 12345, 6 * 7\n"));
+  dup2(null, 1);
+  measure("print_statement", batch_statement);
+  fflush(stdout);
+  dup2(saved, 1);
+  close(null);
+  close(saved);
+  vvtbi_release(&context);
+}
+
+/******************/
+/* Start program. */
+/******************/
+
+int main (void)
+{
+  results = fdopen(dup(1), "w");
+  if (!results)
+    return EXIT_FAILURE;
+  fprintf(results, "{\"benchmarks\": [");
+
+  bench_tokenizer("tokenizer_number",   "12345678 ");
+  bench_tokenizer("tokenizer_letter",   "a b c d ");
+  bench_tokenizer("tokenizer_string",   "\"hello, world\" ");
+  bench_tokenizer("tokenizer_operator", "+ - * / ( ) ");
+  bench_tokenizer("tokenizer_relation", "< > <= >= <> = ");
+  bench_tokenizer("tokenizer_keyword",  "LET IF THEN PRINT GOTO ");
+  bench_tokenizer("tokenizer_eol",      "\n");
+
+  repeat("10 LET a = b + 1\n");
+  measure("io_next", batch_io);
+
+  /* Names are slots once loaded, whatever their length. */
+  bench_statement("variable_name_short", "10 LET a = a + b\n");
+  bench_statement("variable_name_long",
+    "10 LET running_total = running_total + increment_by\n");
+
+  bench_expression(1);
+  bench_expression(8);
+  bench_expression(64);
+
+  bench_lines(16, 10);
+  bench_lines(256, 10);
+  bench_lines(4096, 10);
+  bench_lines(65536, 10);
+  bench_lines(16, 1000);
+  bench_lines(256, 1000);
+  bench_lines(4096, 1000);
+  bench_lines(65536, 1000);
+
+  /* Loops over literal bounds have their indexes proven, the
+     same loop up to a variable checks them. */
+  bench_array("array_fill",
+    "10 DIM a(999)\n20 FOR i = 0 TO 999\n30 a(i) = i\n40 NEXT i\n");
+  bench_array("array_sum",
+    "10 DIM a(999)\n20 FOR i = 0 TO 999\n30 s = s + a(i)\n"
+    "40 NEXT i\n");
+  bench_array("array_sum_checked",
+    "10 DIM a(999)\n15 n = 999\n20 FOR i = 0 TO n\n"
+    "30 s = s + a(i)\n40 NEXT i\n");
+  bench_array("array_scan",
+    "10 DIM a(1000)\n20 FOR i = 1 TO 1000\n"
+    "30 a(i) = a(i - 1) + i\n40 NEXT i\n50 s = a(1000)\n");
+
+  /* The same loop on int, 64-bit and decimal variables; the
+     int loop runs the code it ran before there were types. */
+  bench_typed("typed_integer",
+    "10 FOR i = 1 TO 1000\n20 s = s + i * 3\n30 NEXT i\n", 0);
+  bench_typed("typed_int64",
+    "10 FOR i = 1 TO 1000\n20 s = s + i * 3\n30 NEXT i\n", 1);
+  bench_typed("typed_decimal",
+    "10 FOR i = 1 TO 1000\n20 s = s + i * 0.5\n30 NEXT i\n", 0);
+
+  /* A divisor proven non-zero at load, and the same loop
+     stepping by an unknown amount, its divisor checked. */
+  bench_typed("divide_proven",
+    "10 FOR i = 1 TO 1000 STEP 1\n20 s = s + 1000 / i\n30 NEXT i\n", 0);
+  bench_typed("divide_checked",
+    "10 DIM a(0)\n15 a(0) = 1\n20 FOR i = 1 TO 1000 STEP a(0)\n"
+    "30 s = s + 1000 / i\n40 NEXT i\n", 0);
+
+  /* As typed_integer, through a host function. */
+  bench_call();
+
+  /* As typed_integer, summing DATA. */
+  bench_read();
+
+  bench_print();
+
+  fprintf(results, "\n]}\n");
+  fclose(results);
+  free(input);
+  return EXIT_SUCCESS;
+}
+
+/********/
+/* End. */
+/********/
\ No newline at end of file
@@ -0,0 +1,780 @@
+/***********************************
+   check.c, @format.new-line  lf
+            @format.use-tabs  false
+   @format.tab-size    2
+   @format.indent-size 2
+   @format.line-length 80
+************************************/
+/* fork, pipe and open_memstream are POSIX, not ANSI. */
+#ifdef VVTBI_POSIX
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#ifdef VVTBI_POSIX
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#endif
+
+#include "config.h"
+#include "io.h"
+#include "tokenizer.h"
+#include "program.h"
+#include "check.h"
+#include "vvtbi.h"
+
+#ifdef VVTBI_POSIX
+/* What a worker reports of each file it checked,
+   followed by as many characters of diagnostics. */
+struct check_result {
+  unsigned long errors;
+  size_t        length;
+};
+#endif
+
+/* The program being checked. */
+static const struct program *program;
+
+/* The index of the current token. */
+static size_t pc;
+
+/* The stream diagnostics are written to. */
+static FILE *out;
+
+/* The amount of errors found in the program. */
+static unsigned long errors;
+
+/* The source offset, line and column last reported at,
+   and the offset of that line. */
+static size_t position, row_position;
+static int    row, column;
+
+/* The program's line numbers, sorted. */
+static int *numbers;
+
+static int expression (void);
+
+/******************************************************************************/
+
+/**
+ * locate
+ *
+ * @param offset A source offset.
+ * @return void
+ */
+
+static void locate (size_t offset)
+{
+  const char *source;
+  source = program->source;
+  /* Diagnostics are mostly in source order, so count on from the
+     last; a line's literals are checked before its grammar, so
+     fall back to the start of the line, or of the source. */
+  if (offset < position)
+  {
+    if (offset >= row_position)
+      position = row_position;
+    else
+      position = row_position = 0, row = 1;
+    column = 1;
+  }
+  for (; position < offset && position < program->length; position++)
+  {
+    if (source[position] == '\n' ||
+    (source[position] == '\r' && source[position + 1] != '\n'))
+    {
+      row++;
+      column       = 1;
+      row_position = position + 1;
+    }
+    else if (source[position] != '\r')
+      column++;
+  }
+}
+
+/**
+ * report
+ *
+ * @param offset The source offset of the error.
+ * @param format Message format.
+ * @param ... Additional arguments.
+ * @return void
+ */
+
+static void report (long offset, const char *format, ...)
+{
+  va_list args;
+
+  locate((size_t) offset);
+  fprintf(out, "%s:%d:%d: error: ", program->file, row, column);
+  va_start(args, format);
+  vfprintf(out, format, args);
+  va_end(args);
+  fprintf(out, "\n");
+  errors++;
+}
+
+/**
+ * current_token
+ *
+ * @param void
+ * @return token The current token.
+ */
+
+static int current_token (void)
+{
+  return program->tokens[pc].token;
+}
+
+/**
+ * near
+ *
+ * @param dest The text near the current token.
+ * @param n The size of dest.
+ * @return dest
+ */
+
+static char *near (char *dest, size_t n)
+{
+  const char *source;
+  size_t      i;
+  source = program->source + program->tokens[pc].offset;
+  for (i = 0; i + 1 < n && source[i] &&
+  source[i] != '\r' && source[i] != '\n'; i++)
+    dest[i] = source[i];
+  dest[i] = 0;
+  /* If empty, EOL or EOF! */
+  if (!i)
+    return current_token() == T_EOF ? "EOF" : "EOL";
+  return dest;
+}
+
+/**
+ * accept
+ *
+ * @param token The token expected.
+ * @return Was it the current token? If so, it is skipped.
+ */
+
+static int accept (int token)
+{
+  char string[10];
+  if (token != current_token())
+  {
+    report(program->tokens[pc].offset,
+      "unexpected `%s' near `%s', expected: `%s'",
+      vvtbi_token(current_token()),
+      near(string, sizeof string),
+      vvtbi_token(token));
+    return 0;
+  }
+  /* The T_EOF token is never passed. */
+  if (token != T_EOF)
+    pc++;
+  return 1;
+}
+
+/**
+ * compare
+ *
+ * @param a A line number.
+ * @param b A line number.
+ * @return Their order.
+ */
+
+static int compare (const void *a, const void *b)
+{
+  int x, y;
+  x = *(const int *) a;
+  y = *(const int *) b;
+  return (x > y) - (x < y);
+}
+
+/**
+ * target
+ *
+ * @param void
+ * @return Is the current token the number of an existing line?
+ */
+
+static int target (void)
+{
+  char number[VVTBI_NUMBER_LITERAL + 2];
+  int  to;
+  if (current_token() != T_NUMBER)
+    return accept(T_NUMBER);
+  to = program->tokens[pc].value;
+  if (!bsearch(&to, numbers, program->lines_count, sizeof *numbers,
+    compare))
+    report(program->tokens[pc].offset,
+      "line number `%s' does not exist",
+      near(number, sizeof number));
+  pc++;
+  return 1;
+}
+
+/**
+ * variable
+ *
+ * @param void
+ * @return Was a variable, or an array element, parsed?
+ */
+
+static int variable (void)
+{
+  char string[10];
+  if (current_token() != T_LETTER ||
+  program->tokens[pc + 1].token != T_LEFT_PAREN)
+    return accept(T_LETTER);
+  if (!program->arrays[program->tokens[pc].value].length)
+    report(program->tokens[pc].offset,
+      "array not dimensioned near `%s'",
+      near(string, sizeof string));
+  pc++;
+  return accept(T_LEFT_PAREN) &&
+    expression() &&
+    accept(T_RIGHT_PAREN);
+}
+
+/**
+ * call
+ *
+ * @param void
+ * @return Was a CALL of a host function parsed?
+ */
+
+static int call (void)
+{
+  char string[10];
+  int  count;
+  if (!(accept(T_CALL) && accept(T_FUNCTION) && accept(T_LEFT_PAREN)))
+    return 0;
+  for (count = 0; current_token() != T_RIGHT_PAREN; count++)
+  {
+    if (count && !accept(T_SEPERATOR))
+      return 0;
+    if (count == VVTBI_ARGUMENTS)
+      report(program->tokens[pc].offset,
+        "more than %d arguments near `%s'", VVTBI_ARGUMENTS,
+        near(string, sizeof string));
+    if (!expression())
+      return 0;
+  }
+  return accept(T_RIGHT_PAREN);
+}
+
+/**
+ * factor
+ *
+ * @param void
+ * @return Was a factor parsed?
+ */
+
+static int factor (void)
+{
+  switch (current_token())
+  {
+    case T_NUMBER:
+    case T_WIDE:
+    case T_DECIMAL:
+      pc++;
+      return 1;
+    case T_LEFT_PAREN:
+      return accept(T_LEFT_PAREN) &&
+        expression() &&
+        accept(T_RIGHT_PAREN);
+    case T_CALL:
+      return call();
+    default:
+      return variable();
+  }
+}
+
+/**
+ * term
+ *
+ * @param void
+ * @return Was a term parsed?
+ */
+
+static int term (void)
+{
+  if (!factor())
+    return 0;
+  while (current_token() == T_ASTERISK ||
+  current_token() == T_SLASH)
+  {
+    pc++;
+    if (!factor())
+      return 0;
+  }
+  return 1;
+}
+
+/**
+ * expression
+ *
+ * @param void
+ * @return Was an expression parsed?
+ */
+
+static int expression (void)
+{
+  if (!term())
+    return 0;
+  while (current_token() == T_PLUS ||
+  current_token() == T_MINUS)
+  {
+    pc++;
+    if (!term())
+      return 0;
+  }
+  return 1;
+}
+
+/**
+ * relation
+ *
+ * @param void
+ * @return Was a relation parsed?
+ */
+
+static int relation (void)
+{
+  int op;
+  if (!expression())
+    return 0;
+  for (op = current_token();
+  op == T_EQUAL || op == T_LT || op == T_GT ||
+  op == T_LT_EQ || op == T_GT_EQ || op == T_NOT_EQUAL;
+  op = current_token())
+  {
+    pc++;
+    if (!expression())
+      return 0;
+  }
+  return 1;
+}
+
+/**
+ * print_statement
+ *
+ * @param void
+ * @return Was the statement parsed?
+ */
+
+static int print_statement (void)
+{
+  for (pc++;; )
+  {
+    switch (current_token())
+    {
+      case T_STRING:
+      case T_SEPERATOR:
+        pc++;
+        break;
+      case T_LETTER:
+      case T_NUMBER:
+      case T_WIDE:
+      case T_DECIMAL:
+      case T_LEFT_PAREN:
+      case T_CALL:
+        if (!expression())
+          return 0;
+        break;
+      default:
+        return accept(T_EOL);
+    }
+  }
+}
+
+/**
+ * statement
+ *
+ * @param void
+ * @return Was the statement parsed?
+ */
+
+static int statement (void)
+{
+  char string[10];
+  switch (current_token())
+  {
+    case T_REM:
+      pc++;
+      return accept(T_EOL);
+    case T_PRINT:
+      return print_statement();
+    case T_IF:
+      pc++;
+      return relation() &&
+        accept(T_THEN) &&
+        target() &&
+        accept(T_EOL);
+    case T_GOTO:
+    case T_GOSUB:
+      pc++;
+      return target() && accept(T_EOL);
+    case T_RETURN:
+      pc++;
+      return accept(T_EOL);
+    case T_FOR:
+      pc++;
+      if (!(accept(T_LETTER) && accept(T_EQUAL) && expression() &&
+      accept(T_TO) && expression()))
+        return 0;
+      if (current_token() == T_STEP)
+      {
+        pc++;
+        if (!expression())
+          return 0;
+      }
+      return accept(T_EOL);
+    case T_NEXT:
+      pc++;
+      if (current_token() == T_LETTER)
+        pc++;
+      return accept(T_EOL);
+    case T_DIM:
+      /* Sizes are numbers, for the arena is laid out on load. */
+      for (pc++;; pc++)
+      {
+        if (!(accept(T_LETTER) && accept(T_LEFT_PAREN) &&
+        accept(T_NUMBER) && accept(T_RIGHT_PAREN)))
+          return 0;
+        if (current_token() != T_SEPERATOR)
+          return accept(T_EOL);
+      }
+    case T_CALL:
+      return call() && accept(T_EOL);
+    case T_INCLUDE:
+    case T_CHAIN:
+      pc++;
+      return accept(T_STRING) && accept(T_EOL);
+    case T_INPUT:
+    case T_READ:
+      for (pc++;; pc++)
+      {
+        if (!variable())
+          return 0;
+        if (current_token() != T_SEPERATOR)
+          return accept(T_EOL);
+      }
+    /* Items are numbers, for DATA is packed as int on load. */
+    case T_DATA:
+      for (pc++;; pc++)
+      {
+        if (current_token() == T_MINUS)
+          pc++;
+        if (!accept(T_NUMBER))
+          return 0;
+        if (current_token() != T_SEPERATOR)
+          return accept(T_EOL);
+      }
+    case T_LET:
+      pc++;
+    /* Fall through... */
+    case T_LETTER:
+      return variable() &&
+        accept(T_EQUAL) &&
+        expression() &&
+        accept(T_EOL);
+    default:
+      report(program->tokens[pc].offset,
+        "statement not implemented near `%s'",
+        near(string, sizeof string));
+      return 0;
+  }
+}
+
+/**
+ * check_literals
+ *
+ * @param end The index of the token ending the line.
+ * @return Were the line's literals well-formed?
+ */
+
+static int check_literals (size_t end)
+{
+  const struct program_token *t;
+  const char                 *source, *quote;
+  unsigned long               found;
+  found = errors;
+  /* Past the first, the scanner may be out of step. */
+  for (t = &program->tokens[pc];
+  t < &program->tokens[end] && errors == found; t++)
+  {
+    source = program->source + t->offset;
+    switch (t->token)
+    {
+      case T_ERROR:
+        /* The scanner gives up on a number too long. */
+        if (*source >= '0' && *source <= '9')
+          report(t->offset, "number exceeds %d digits, or %d after "
+            "the point", VVTBI_WIDE_LITERAL, VVTBI_DECIMAL_DIGITS);
+        else if (*source >= 'a' && *source <= 'z')
+          report(t->offset, "variable name exceeds %d characters",
+            VVTBI_NAME_LENGTH);
+        else
+          report(t->offset, "unrecognized character `%c'", *source);
+        break;
+      case T_STRING:
+        quote = memchr(source + 1, '"',
+          program->length - t->offset - 1);
+        if (!quote)
+          report(t->offset, "unterminated string literal");
+        else if (quote - source - 1 > VVTBI_STRING_LITERAL)
+          report(t->offset,
+            "string literal truncated to %d characters",
+            VVTBI_STRING_LITERAL);
+        break;
+    }
+  }
+  return errors == found;
+}
+
+/**
+ * check_program
+ *
+ * @param p The compiled program.
+ * @param stream The stream to write diagnostics to.
+ * @return errors The amount of errors found.
+ */
+
+unsigned long check_program (const struct program *p, FILE *stream)
+{
+  size_t i, end;
+
+  program  = p;
+  out      = stream;
+  errors   = 0;
+  position = row_position = 0;
+  row      = column = 1;
+  numbers  = malloc((p->lines_count + 1) * sizeof *numbers);
+  if (!numbers)
+  {
+    fprintf(stderr, "*check.c: out of memory!\n");
+    return 1;
+  }
+  for (i = 0; i < p->lines_count; i++)
+    numbers[i] = p->lines[i].number;
+  qsort(numbers, p->lines_count, sizeof *numbers, compare);
+  for (pc = 0; current_token() != T_EOF; )
+  {
+    /* Skip irrelevant new-lines. */
+    if (current_token() == T_EOL)
+    {
+      pc++;
+      continue;
+    }
+    for (end = pc; program->tokens[end].token != T_EOL &&
+    program->tokens[end].token != T_EOF; end++)
+      ;
+    /* The lines of INCLUDEd modules are checked with their
+       own files. */
+    if ((size_t) program->tokens[pc].offset >= program->size)
+    {
+      pc = end;
+      continue;
+    }
+    /* Past a malformed literal, the scanner is out of step
+       with the line: report the literal only. Otherwise,
+       on an error, carry on from the next line. */
+    if (!check_literals(end) ||
+    !((current_token() == T_REM || accept(T_NUMBER)) && statement()))
+      pc = end;
+  }
+  free(numbers);
+  return errors;
+}
+
+
+/**
+ * check_source
+ *
+ * @param file The source code file.
+ * @param stream Destination of the diagnostics.
+ * @return The amount of errors found.
+ */
+
+static unsigned long check_source (const char *file, FILE *stream)
+{
+  struct program *p;
+  unsigned long   found;
+  char           *source;
+  size_t          n;
+
+  if (!(source = io_read(file, &n)))
+  {
+    fprintf(stream, "%s: error: cannot be read\n", file);
+    return 1;
+  }
+  p     = program_compile(file, source, n);
+  found = check_program(p, stream);
+  program_release(p);
+  return found;
+}
+
+/**
+ * summary
+ *
+ * @param checked The amount of files checked.
+ * @param total The amount of errors found.
+ * @param failed The amount of files with errors.
+ * @return Were the files free of errors?
+ */
+
+static int summary (unsigned long checked, unsigned long total,
+  unsigned long failed)
+{
+  printf("checked %lu file%s, %lu error%s in %lu file%s\n",
+    checked, checked == 1 ? "" : "s",
+    total, total == 1 ? "" : "s",
+    failed, failed == 1 ? "" : "s");
+  return total == 0;
+}
+
+#ifdef VVTBI_POSIX
+/**
+ * check_file
+ *
+ * @param file The source code file.
+ * @param result Destination of the errors and diagnostics' length.
+ * @return text The diagnostics, or NULL.
+ */
+
+static char *check_file (const char *file, struct check_result *result)
+{
+  FILE *stream;
+  char *text;
+
+  text           = NULL;
+  result->errors = 0;
+  result->length = 0;
+  if (!(stream = open_memstream(&text, &result->length)))
+    return NULL;
+  result->errors = check_source(file, stream);
+  fclose(stream);
+  return text;
+}
+#endif
+
+/**
+ * check_files
+ *
+ * @param files The source code files.
+ * @param n The amount of files.
+ * @return Were the files free of errors?
+ */
+
+int check_files (char **files, int n)
+{
+#ifdef VVTBI_POSIX
+  struct check_result result;
+  pid_t              *workers;
+  int                *pipes, fd[2];
+  int                 i, k, w, first, last, status;
+  unsigned long       total, failed, checked;
+  long                cores;
+  char               *text;
+
+  /* Each worker checks a contiguous run of files, so reading
+     the workers in order reports the files in order. */
+  cores = sysconf(_SC_NPROCESSORS_ONLN);
+  w     = cores > 1 ? (int) cores : 1;
+  if (w > n)
+    w = n;
+  workers = malloc(w * sizeof *workers);
+  pipes   = malloc(w * sizeof *pipes);
+  if (!workers || !pipes)
+  {
+    fprintf(stderr, "*check.c: out of memory!\n");
+    return 0;
+  }
+  fflush(stdout);
+  for (k = 0; k < w; k++)
+  {
+    first      = (int) ((long) n * k / w);
+    last       = (int) ((long) n * (k + 1) / w);
+    workers[k] = -1;
+    pipes[k]   = -1;
+    if (pipe(fd))
+      continue;
+    workers[k] = fork();
+    if (workers[k] == 0)
+    {
+      /* The worker: it owns the scanner, no need to share it. */
+      close(fd[0]);
+      for (i = first; i < last; i++)
+      {
+        text = check_file(files[i], &result);
+        if (!text)
+          result.length = 0;
+        if (!io_transfer(fd[1], &result, sizeof result, 1) ||
+        !io_transfer(fd[1], text, result.length, 1))
+          _exit(EXIT_FAILURE);
+        free(text);
+      }
+      _exit(EXIT_SUCCESS);
+    }
+    close(fd[1]);
+    if (workers[k] < 0)
+      close(fd[0]);
+    else
+      pipes[k] = fd[0];
+  }
+  total = failed = checked = 0;
+  for (k = 0; k < w; k++)
+  {
+    first = (int) ((long) n * k / w);
+    last  = (int) ((long) n * (k + 1) / w);
+    for (i = first; pipes[k] >= 0 && i < last; i++)
+    {
+      if (!io_transfer(pipes[k], &result, sizeof result, 0))
+        break;
+      text = malloc(result.length + 1);
+      if (!text || !io_transfer(pipes[k], text, result.length, 0))
+      {
+        free(text);
+        break;
+      }
+      fwrite(text, 1, result.length, stdout);
+      free(text);
+      total  += result.errors;
+      failed += result.errors > 0;
+      checked++;
+    }
+    /* A worker lost is its files unchecked. */
+    for (; i < last; i++)
+    {
+      printf("%s: error: not checked\n", files[i]);
+      total++;
+      failed++;
+    }
+    if (pipes[k] >= 0)
+      close(pipes[k]);
+    if (workers[k] > 0)
+      waitpid(workers[k], &status, 0);
+  }
+  free(workers);
+  free(pipes);
+  return summary(checked, total, failed);
+#else
+  unsigned long found, total, failed;
+  int           i;
+
+  /* No workers without POSIX: the files are checked one by one. */
+  total = failed = 0;
+  for (i = 0; i < n; i++)
+  {
+    found   = check_source(files[i], stdout);
+    total  += found;
+    failed += found > 0;
+  }
+  return summary((unsigned long) n, total, failed);
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,18 @@
+/***********************************
+   check.h, @format.new-line  lf
+            @format.use-tabs  false
+   @format.tab-size    2
+   @format.indent-size 2
+   @format.line-length 80
+************************************/
+#ifndef _CHECK_H__
+#define _CHECK_H__
+
+#include <stdio.h>
+
+#include "program.h"
+
+unsigned long check_program (const struct program *p, FILE *out);
+int           check_files   (char **files, int n);
+
+#endif /* _CHECK_H__ */
\ No newline at end of file
@@ -15,4 +15,131 @@
 
 #define VVTBI_NUMBER_LITERAL     8
 
+/* The maximum length of 64-bit
+   [whole] number literals, kept in a
+   long: 19 digits would overflow it.
+   Where a long is 32-bit, as ANSI
+   allows, they are no longer than the
+   narrow length. */
+
+#define VVTBI_WIDE_LITERAL       18
+#define VVTBI_NARROW_LITERAL     9
+
+/* The digits kept after the point of
+   decimal numbers, which are fixed-point
+   in VVTBI_DECIMAL_SCALE. */
+
+#define VVTBI_DECIMAL_DIGITS     4
+#define VVTBI_DECIMAL_SCALE      10000L
+
+/* The maximum length of
+   variable names. */
+
+#define VVTBI_NAME_LENGTH        32
+
+/* The default amount of line-statements
+   a script runs before the scheduler
+   moves on to the next. */
+
+#define VVTBI_SCHEDULER_BUDGET   64
+
+/* The amount of compiled programs
+   kept in the program cache. */
+
+#define VVTBI_PROGRAM_CACHE      16
+
+/* The socket vvtbid serves runs on,
+   unless $VVTBI_SOCKET is set: socket,
+   in a directory of the user's own, of
+   this name and the user's id; its most
+   workers, a worker per core; and the
+   longest path or inline source a
+   request may send. */
+
+#define VVTBI_SOCKET             "/tmp/vvtbi-"
+#define VVTBI_DAEMON_WORKERS     64
+#define VVTBI_DAEMON_SOURCE      (1 << 26)
+
+/* The least characters a chunk of
+   source code is scanned in, and the
+   most chunks scanned at once: a large
+   source is scanned by a worker process
+   per core. */
+
+#define VVTBI_LOAD_CHUNK         (1 << 20)
+#define VVTBI_LOAD_WORKERS       64
+
+/* The deepest INCLUDEs may nest. */
+
+#define VVTBI_INCLUDE_DEPTH      16
+
+/* The most ranges, lines times
+   variables, the divisions of a
+   program are proven with; and the
+   rounds before a range still
+   growing is taken to grow on. */
+
+#define VVTBI_RANGE_CELLS        (1 << 20)
+#define VVTBI_RANGE_ROUNDS       4
+
+/* The most line numbers spanned per
+   line for the line table to be mapped
+   directly, rather than searched. */
+
+#define VVTBI_LINE_SPAN          16
+
+/* The alignment of array storage,
+   in bytes: a cache line. */
+
+#define VVTBI_ARENA_ALIGN        64
+
+/* The amount of times a line must
+   run, in a recorded profile, for
+   its jump to be resolved at load. */
+
+#define VVTBI_PROFILE_HOT        16
+
+/* The interval, in microseconds of
+   CPU time, between samples. */
+
+#define VVTBI_SAMPLE_INTERVAL    1000
+
+/* The most functions vvtbi_hook
+   may install. */
+
+#define VVTBI_HOOKS              4
+
+/* The size, in bytes, and amount of
+   the buffers PRINT fills with
+   -async-output, for a thread to write. */
+
+#define VVTBI_OUTPUT_BUFFER      (1 << 18)
+#define VVTBI_OUTPUT_BUFFERS     2
+
+/* The size, in bytes, of the blocks
+   INPUT reads at once. */
+
+#define VVTBI_INPUT_BUFFER       (1 << 16)
+
+/* The amount of line-statements kept
+   by the trace; a power of two. */
+
+#define VVTBI_TRACE_SIZE         1024
+
+/* The deepest FOR loops may nest. */
+
+#define VVTBI_LOOPS              16
+
+/* The deepest GOSUBs may nest. */
+
+#define VVTBI_RETURNS            64
+
+/* The most host functions
+   vvtbi_register may install in a
+   context, and the most arguments
+   one may take. */
+
+#define VVTBI_FUNCTIONS          32
+#define VVTBI_ARGUMENTS          8
+
 #endif /* _CONFIG_H__ */
\ No newline at end of file
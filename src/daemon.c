@@ -0,0 +1,535 @@
+/************************************
+   daemon.c, @format.new-line  lf
+             @format.use-tabs  false
+   @format.tab-size    2
+   @format.indent-size 2
+   @format.line-length 80
+*************************************/
+/* Sockets, fork and sigaction are POSIX, not ANSI; a peer's
+   credentials, SO_PEERCRED, are Linux's. */
+#ifdef VVTBI_POSIX
+#define _GNU_SOURCE
+#endif
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+
+#ifdef VVTBI_POSIX
+#include <signal.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#endif
+
+#include "config.h"
+#include "io.h"
+#include "program.h"
+#include "vvtbi.h"
+#include "daemon.h"
+#include "input.h"
+
+#ifdef VVTBI_POSIX
+
+/* The descriptors sent with a request: stdin, stderr, status. */
+#define DESCRIPTORS 3
+
+/* Control data room for the descriptors, aligned for them. */
+union control {
+  struct cmsghdr header;
+  char           data[CMSG_SPACE(DESCRIPTORS * sizeof (int))];
+};
+
+/* Was the daemon told to stop? */
+static volatile sig_atomic_t stopping = 0;
+
+/******************************************************************************/
+
+/**
+ * stop
+ *
+ * @param signal The signal received.
+ * @return void
+ */
+
+static void stop (int signal)
+{
+  (void) signal;
+  stopping = 1;
+}
+
+/**
+ * owned
+ *
+ * @param path A file.
+ * @param type The type it must be, S_IFSOCK or S_IFDIR.
+ * @return 1 if the file is of that type, the user's and, a
+ *         directory, closed to others; 0 if there is none; -1 if
+ *         it is not to be trusted.
+ */
+
+static int owned (const char *path, mode_t type)
+{
+  struct stat info;
+  if (lstat(path, &info))
+    return errno == ENOENT ? 0 : -1;
+  return (info.st_mode & S_IFMT) == type && info.st_uid == getuid() &&
+    (type != S_IFDIR || !(info.st_mode & (S_IRWXG | S_IRWXO))) ? 1 : -1;
+}
+
+/**
+ * secure
+ *
+ * @param path The socket's path.
+ * @param create Create the default socket's directory?
+ * @return 1 if the socket, and the default's directory, are the
+ *         user's own; 0 if either is missing; -1, reported, if
+ *         either is another's.
+ */
+
+static int secure (const char *path, int create)
+{
+  char        directory[sizeof VVTBI_SOCKET + 32];
+  const char *chosen;
+  int         own;
+
+  own    = 1;
+  chosen = getenv("VVTBI_SOCKET");
+  if (!chosen || !*chosen)
+  {
+    sprintf(directory, "%s%lu", VVTBI_SOCKET, (unsigned long) getuid());
+    if (create)
+      mkdir(directory, S_IRWXU);
+    own = owned(directory, S_IFDIR);
+  }
+  if (own > 0)
+    own = owned(path, S_IFSOCK);
+  if (own < 0)
+    fprintf(stderr, "*daemon.c: `%s' is not the user's own!\n", path);
+  return own;
+}
+
+/**
+ * trusted
+ *
+ * @param conn A connection.
+ * @return Is the process at its other end the user's? Where the
+ *         system cannot tell, the socket's directory is relied on.
+ */
+
+static int trusted (int conn)
+{
+#ifdef SO_PEERCRED
+  struct ucred peer;
+  socklen_t    n;
+  n = sizeof peer;
+  return !getsockopt(conn, SOL_SOCKET, SO_PEERCRED, &peer, &n) &&
+    peer.uid == getuid();
+#else
+  (void) conn;
+  return 1;
+#endif
+}
+
+/**
+ * connect_to
+ *
+ * @param path The socket's path.
+ * @param address Destination of the socket's address.
+ * @return A socket, or -1 if the path is too long.
+ */
+
+static int connect_to (const char *path, struct sockaddr_un *address)
+{
+  if (strlen(path) >= sizeof address->sun_path)
+  {
+    fprintf(stderr, "*daemon.c: socket `%s' is too long!\n", path);
+    return -1;
+  }
+  memset(address, 0, sizeof *address);
+  address->sun_family = AF_UNIX;
+  strcpy(address->sun_path, path);
+  return socket(AF_UNIX, SOCK_STREAM, 0);
+}
+
+/**
+ * receive_request
+ *
+ * @param conn The connection.
+ * @param request Destination of the request.
+ * @param fds Destination of the descriptors sent with it.
+ * @return Was a whole request, with its descriptors, received?
+ */
+
+static int receive_request (int conn, struct daemon_request *request,
+  int *fds)
+{
+  struct msghdr   message;
+  struct iovec    vector;
+  struct cmsghdr *header;
+  union control   control;
+  ssize_t         n;
+  size_t          k, count;
+
+  memset(&message, 0, sizeof message);
+  vector.iov_base        = request;
+  vector.iov_len         = sizeof *request;
+  message.msg_iov        = &vector;
+  message.msg_iovlen     = 1;
+  message.msg_control    = control.data;
+  message.msg_controllen = sizeof control.data;
+  while ((n = recvmsg(conn, &message, 0)) < 0 && errno == EINTR)
+    ;
+  header = n > 0 ? CMSG_FIRSTHDR(&message) : NULL;
+  if (!header || header->cmsg_level != SOL_SOCKET ||
+  header->cmsg_type != SCM_RIGHTS)
+    return 0;
+  count = (header->cmsg_len - CMSG_LEN(0)) / sizeof (int);
+  memcpy(fds, CMSG_DATA(header), count * sizeof (int));
+  /* The rest of the request, if the first read fell short. */
+  if (count != DESCRIPTORS || ((size_t) n < sizeof *request &&
+  !io_transfer(conn, (char *) request + n, sizeof *request - n, 0)))
+  {
+    for (k = 0; k < count; k++)
+      close(fds[k]);
+    return 0;
+  }
+  return 1;
+}
+
+/**
+ * receive_text
+ *
+ * @param conn The connection.
+ * @param n The amount of characters sent.
+ * @return The characters, null-terminated, or NULL.
+ */
+
+static char *receive_text (int conn, size_t n)
+{
+  char *text;
+  if (n > VVTBI_DAEMON_SOURCE || !(text = malloc(n + 1)))
+    return NULL;
+  if (!io_transfer(conn, text, n, 0))
+  {
+    free(text);
+    return NULL;
+  }
+  text[n] = 0;
+  return text;
+}
+
+/**
+ * serve
+ *
+ * @param listener The daemon's socket.
+ * @return void
+ */
+
+static void serve (int listener)
+{
+  struct daemon_request request;
+  struct vvtbi_context  ctx;
+  struct program       *p;
+  unsigned char         status;
+  char                 *path, *source;
+  int                   conn, fds[DESCRIPTORS], saved[3], k;
+
+  for (k = 0; k < 3; k++)
+    saved[k] = dup(k);
+  for (;;)
+  {
+    if ((conn = accept(listener, NULL, NULL)) < 0)
+      continue;
+    /* Only the user's own processes are served. */
+    if (!trusted(conn) || !receive_request(conn, &request, fds))
+    {
+      close(conn);
+      continue;
+    }
+    path   = receive_text(conn, request.path_length);
+    source = request.kind == DAEMON_SOURCE ?
+      receive_text(conn, request.source_length) : NULL;
+    if (!path || (request.kind == DAEMON_SOURCE && !source) ||
+    (request.kind != DAEMON_SOURCE && request.kind != DAEMON_PATH))
+    {
+      free(path);
+      free(source);
+      for (k = 0; k < DESCRIPTORS; k++)
+        close(fds[k]);
+      close(conn);
+      continue;
+    }
+    /* The script reads the client's stdin, and reports errors
+       to its stderr; PRINT goes back over the connection. An
+       error exits the worker, and closes the status unwritten. */
+    dup2(fds[0], STDIN_FILENO);
+    dup2(conn, STDOUT_FILENO);
+    dup2(fds[1], STDERR_FILENO);
+    close(fds[0]);
+    close(fds[1]);
+    close(conn);
+    /* Compiled once per worker, and cached by its content. */
+    p = request.kind == DAEMON_SOURCE ?
+      program_source(path, source, request.source_length) :
+      program_load(path);
+    vvtbi_attach(&ctx, p);
+    while (!ctx.finished)
+      vvtbi_step(&ctx, VVTBI_SCHEDULER_BUDGET);
+    vvtbi_release(&ctx);
+    fflush(stdout);
+    /* Input buffered, and unread, was the client's alone. */
+    input_close();
+    for (k = 0; k < 3; k++)
+      dup2(saved[k], k);
+    status = EXIT_SUCCESS;
+    io_transfer(fds[2], &status, 1, 1);
+    close(fds[2]);
+    free(path);
+  }
+}
+
+/**
+ * spawn
+ *
+ * @param listener The daemon's socket.
+ * @return The worker's process, or -1.
+ */
+
+static pid_t spawn (int listener)
+{
+  pid_t worker;
+  worker = fork();
+  if (worker == 0)
+  {
+    signal(SIGTERM, SIG_DFL);
+    signal(SIGINT, SIG_DFL);
+    serve(listener);
+    _exit(EXIT_SUCCESS);
+  }
+  return worker;
+}
+
+#endif
+
+/**
+ * daemon_socket
+ *
+ * @param void
+ * @return The path of the daemon's socket: $VVTBI_SOCKET, or
+ *         socket in the user's directory, VVTBI_SOCKET and the
+ *         user's id.
+ */
+
+const char *daemon_socket (void)
+{
+  static char standard[sizeof VVTBI_SOCKET + 32];
+  const char *path;
+  path = getenv("VVTBI_SOCKET");
+  if (path && *path)
+    return path;
+#ifdef VVTBI_POSIX
+  sprintf(standard, "%s%lu/socket", VVTBI_SOCKET,
+    (unsigned long) getuid());
+#else
+  sprintf(standard, "%ssocket", VVTBI_SOCKET);
+#endif
+  return standard;
+}
+
+/**
+ * daemon_run
+ *
+ * @param void
+ * @return Did the daemon start, and stop when told?
+ */
+
+int daemon_run (void)
+{
+#ifdef VVTBI_POSIX
+  struct sockaddr_un address;
+  struct sigaction   action;
+  pid_t              workers[VVTBI_DAEMON_WORKERS], worker;
+  const char        *path;
+  long               cores;
+  int                listener, probe, own, k, w;
+
+  path = daemon_socket();
+  if ((listener = connect_to(path, &address)) < 0)
+    return 0;
+  if ((own = secure(path, 1)) < 0)
+  {
+    close(listener);
+    return 0;
+  }
+  /* A socket left by a daemon that is gone is replaced; one
+     that is answered is in use. */
+  if (own && (probe = socket(AF_UNIX, SOCK_STREAM, 0)) >= 0 &&
+  !connect(probe, (struct sockaddr *) &address, sizeof address))
+  {
+    fprintf(stderr, "*daemon.c: `%s' is in use!\n", path);
+    close(probe);
+    close(listener);
+    return 0;
+  }
+  if (own && probe >= 0)
+    close(probe);
+  if (own)
+    unlink(path);
+  if (bind(listener, (struct sockaddr *) &address, sizeof address) ||
+  listen(listener, SOMAXCONN))
+  {
+    fprintf(stderr, "*daemon.c: socket `%s' failed!\n", path);
+    close(listener);
+    return 0;
+  }
+  memset(&action, 0, sizeof action);
+  action.sa_handler = stop;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGTERM, &action, NULL);
+  sigaction(SIGINT, &action, NULL);
+  /* A worker per core, each accepting requests in turn; the
+     interpreter is the worker's own. */
+  cores = sysconf(_SC_NPROCESSORS_ONLN);
+  w     = cores < 1 ? 1 : cores > VVTBI_DAEMON_WORKERS ?
+    VVTBI_DAEMON_WORKERS : (int) cores;
+  fflush(stdout);
+  for (k = 0; k < w; k++)
+    workers[k] = spawn(listener);
+  /* A worker lost, to an error in a script, is replaced. */
+  while (!stopping)
+  {
+    if ((worker = wait(NULL)) < 0)
+    {
+      if (errno != EINTR)
+        break;
+      continue;
+    }
+    for (k = 0; k < w; k++)
+      if (workers[k] == worker && !stopping)
+        workers[k] = spawn(listener);
+  }
+  for (k = 0; k < w; k++)
+    if (workers[k] > 0)
+      kill(workers[k], SIGTERM);
+  while (wait(NULL) > 0 || errno == EINTR)
+    ;
+  close(listener);
+  unlink(path);
+  return 1;
+#else
+  fprintf(stderr,
+    "*daemon.c: vvtbid is unavailable on this platform\n");
+  return 0;
+#endif
+}
+
+/**
+ * daemon_forward
+ *
+ * @param file The script to run, a path.
+ * @param status Destination of the script's exit status.
+ * @return Was the script run by a daemon? If none answered,
+ *         nothing was run.
+ */
+
+int daemon_forward (const char *file, int *status)
+{
+#ifdef VVTBI_POSIX
+  struct sockaddr_un    address;
+  struct daemon_request request;
+  struct msghdr         message;
+  struct iovec          vector;
+  struct cmsghdr       *header;
+  union control         control;
+  unsigned char         byte;
+  char                  buffer[4096], *cwd, *path;
+  size_t                size;
+  ssize_t               n;
+  int                   conn, fds[DESCRIPTORS], done[2];
+
+  if ((conn = connect_to(daemon_socket(), &address)) < 0)
+    return 0;
+  /* The run, and the user's stdin and stderr, go only to a
+     daemon of the user's own. */
+  if (secure(address.sun_path, 0) <= 0 ||
+  connect(conn, (struct sockaddr *) &address, sizeof address) ||
+  !trusted(conn) || pipe(done))
+  {
+    close(conn);
+    return 0;
+  }
+  /* The daemon runs elsewhere: a relative path is made
+     absolute. */
+  for (cwd = NULL, size = sizeof buffer; file[0] != '/'; size *= 2)
+  {
+    free(cwd);
+    if (!(cwd = malloc(size)) || getcwd(cwd, size) || errno != ERANGE)
+      break;
+  }
+  path = malloc((cwd ? strlen(cwd) + 1 : 0) + strlen(file) + 1);
+  if (!path || (file[0] != '/' && (!cwd || !getcwd(cwd, size))))
+  {
+    free(cwd);
+    free(path);
+    close(conn);
+    close(done[0]);
+    close(done[1]);
+    return 0;
+  }
+  if (file[0] == '/')
+    strcpy(path, file);
+  else
+    sprintf(path, "%s/%s", cwd, file);
+  free(cwd);
+
+  memset(&request, 0, sizeof request);
+  request.kind        = DAEMON_PATH;
+  request.path_length = strlen(path);
+  fds[0] = STDIN_FILENO;
+  fds[1] = STDERR_FILENO;
+  fds[2] = done[1];
+  memset(&message, 0, sizeof message);
+  memset(&control, 0, sizeof control);
+  vector.iov_base        = &request;
+  vector.iov_len         = sizeof request;
+  message.msg_iov        = &vector;
+  message.msg_iovlen     = 1;
+  message.msg_control    = control.data;
+  message.msg_controllen = sizeof control.data;
+  header                 = CMSG_FIRSTHDR(&message);
+  header->cmsg_level     = SOL_SOCKET;
+  header->cmsg_type      = SCM_RIGHTS;
+  header->cmsg_len       = CMSG_LEN(sizeof fds);
+  memcpy(CMSG_DATA(header), fds, sizeof fds);
+  n = sendmsg(conn, &message, 0);
+  close(done[1]);
+  if (n != (ssize_t) sizeof request ||
+  !io_transfer(conn, path, request.path_length, 1))
+  {
+    free(path);
+    close(conn);
+    close(done[0]);
+    return 0;
+  }
+  free(path);
+  /* PRINT's output, as it comes, until the script ends. */
+  fflush(stdout);
+  while ((n = read(conn, buffer, sizeof buffer)) > 0 ||
+  (n < 0 && errno == EINTR))
+    if (n > 0 && !io_transfer(STDOUT_FILENO, buffer, n, 1))
+      break;
+  close(conn);
+  *status = io_transfer(done[0], &byte, 1, 0) ? byte : EXIT_FAILURE;
+  close(done[0]);
+  return 1;
+#else
+  (void) file;
+  (void) status;
+  return 0;
+#endif
+}
\ No newline at end of file
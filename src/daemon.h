@@ -0,0 +1,36 @@
+/************************************
+   daemon.h, @format.new-line  lf
+             @format.use-tabs  false
+   @format.tab-size    2
+   @format.indent-size 2
+   @format.line-length 80
+*************************************/
+#ifndef _DAEMON_H__
+#define _DAEMON_H__
+
+#include <stddef.h>
+
+/* What a request runs: a file, by its absolute path, or inline
+   source code, named for its errors. */
+enum {
+  DAEMON_PATH, DAEMON_SOURCE
+};
+
+/* A run request, sent over the socket with the client's stdin,
+   its stderr and the write end of a pipe, in that order, as
+   SCM_RIGHTS. path_length characters of path follow it, then
+   source_length of source code. PRINT is streamed back over the
+   connection until it is closed; the pipe is then written the
+   exit status, a byte, or closed without it if the script ended
+   in an error. */
+struct daemon_request {
+  int    kind;
+  size_t path_length;
+  size_t source_length;
+};
+
+const char *daemon_socket  (void);
+int         daemon_run     (void);
+int         daemon_forward (const char *file, int *status);
+
+#endif /* _DAEMON_H__ */
\ No newline at end of file
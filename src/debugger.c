@@ -0,0 +1,303 @@
+/**************************************
+   debugger.c, @format.new-line  lf
+               @format.use-tabs  false
+   @format.tab-size    2
+   @format.indent-size 2
+   @format.line-length 80
+***************************************/
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "config.h"
+#include "output.h"
+#include "vvtbi.h"
+#include "debugger.h"
+
+/* The program being debugged. */
+static const struct program *debugged = NULL;
+
+/* A flag per line in the line table: is it a breakpoint? */
+static char *breaks = NULL;
+
+/* The amount of breakpoints set. */
+static int break_count = 0;
+
+/* A flag per variable: is it watched? */
+static char *watches = NULL;
+
+/* The amount of watchpoints set. */
+static int watch_count = 0;
+
+/* The watched variables' values, as of the last line. */
+static int *watched = NULL;
+
+/* Stop before the next line? */
+static int stepping = 0;
+
+/* Is the debugger's hook installed? */
+static int hooked = 0;
+
+static void debugger_line (int line);
+
+/******************************************************************************/
+
+/**
+ * update
+ *
+ * @param void
+ * @return void
+ */
+
+static void update (void)
+{
+  int active;
+  /* With nothing to stop for, the hook is removed and the
+     program runs exactly as it would without the debugger. */
+  active = stepping || break_count || watch_count;
+  if (active && !hooked)
+    hooked = vvtbi_hook(debugger_line);
+  else if (!active && hooked)
+  {
+    vvtbi_unhook(debugger_line);
+    hooked = 0;
+  }
+}
+
+/**
+ * print_variable
+ *
+ * @param place The variable's slot.
+ * @return void
+ */
+
+static void print_variable (int place)
+{
+  printf("%s = %d\n", program_name(debugged, place),
+    vvtbi_variable(place));
+}
+
+/**
+ * prompt
+ *
+ * @param line The index of the line about to run, or -1.
+ * @return void
+ */
+
+static void prompt (int line)
+{
+  char input[128], command[64], argument[64];
+  long index;
+  int  place, n;
+
+  /* The program's output so far goes first. */
+  output_flush();
+  if (line >= 0)
+    printf("stopped before line %d\n", debugged->lines[line].number);
+  for (;;)
+  {
+    printf("(vvtbi) ");
+    fflush(stdout);
+    if (!fgets(input, sizeof input, stdin))
+    {
+      /* No more commands; detach and let the program finish. */
+      memset(breaks, 0, debugged->lines_count);
+      memset(watches, 0, debugged->variable_count);
+      break_count = watch_count = stepping = 0;
+      break;
+    }
+    argument[0] = 0;
+    n = sscanf(input, "%63s %63s", command, argument);
+    if (n < 1)
+      continue;
+    /* Single-step. */
+    if (!strcmp(command, "step") || !strcmp(command, "s"))
+    {
+      stepping = 1;
+      break;
+    }
+    /* Continue to the next breakpoint or watchpoint. */
+    else if (!strcmp(command, "continue") || !strcmp(command, "c"))
+    {
+      stepping = 0;
+      break;
+    }
+    /* Set or delete a breakpoint. */
+    else if (!strcmp(command, "break") || !strcmp(command, "b") ||
+    !strcmp(command, "delete") || !strcmp(command, "d"))
+    {
+      if ((index = program_index(debugged, atoi(argument))) < 0)
+      {
+        printf("no line `%s'\n", argument);
+        continue;
+      }
+      if (command[0] == 'b' && !breaks[index])
+        break_count++;
+      else if (command[0] == 'd' && breaks[index])
+        break_count--;
+      breaks[index] = command[0] == 'b';
+    }
+    /* Set or delete a watchpoint. */
+    else if (!strcmp(command, "watch") || !strcmp(command, "unwatch"))
+    {
+      if ((place = program_variable(debugged, argument)) < 0)
+      {
+        printf("no variable `%s'\n", argument);
+        continue;
+      }
+      if (command[0] == 'w' && !watches[place])
+        watch_count++;
+      else if (command[0] == 'u' && watches[place])
+        watch_count--;
+      watches[place] = command[0] == 'w';
+      watched[place] = vvtbi_variable(place);
+    }
+    /* Inspect one variable, or all that are non-zero. */
+    else if (!strcmp(command, "print") || !strcmp(command, "p"))
+    {
+      if (argument[0])
+      {
+        if ((place = program_variable(debugged, argument)) < 0)
+          printf("no variable `%s'\n", argument);
+        else
+          print_variable(place);
+      }
+      else
+      {
+        for (place = 0; (size_t) place < debugged->variable_count;
+        place++)
+          if (vvtbi_variable(place))
+            print_variable(place);
+      }
+    }
+    else if (!strcmp(command, "quit") || !strcmp(command, "q"))
+      exit(EXIT_SUCCESS);
+    else
+      printf("commands: step, continue, break n, delete n, "
+        "watch v, unwatch v, print [v], quit\n");
+  }
+  update();
+}
+
+/**
+ * debugger_line
+ *
+ * @param line The index of the line about to run, or -1.
+ * @return void
+ */
+
+static void debugger_line (int line)
+{
+  int place, stop;
+  stop = stepping || (line >= 0 && breaks[line]);
+  /* A watched variable changed in the line just run. */
+  if (watch_count)
+  {
+    for (place = 0; (size_t) place < debugged->variable_count; place++)
+      if (watches[place] && watched[place] != vvtbi_variable(place))
+      {
+        output_flush();
+        printf("%s: %d -> %d\n", program_name(debugged, place),
+          watched[place], vvtbi_variable(place));
+        watched[place] = vvtbi_variable(place);
+        stop = 1;
+      }
+  }
+  if (stop)
+    prompt(line);
+}
+
+/**
+ * debugger_start
+ *
+ * @param p The program to debug, before its first line.
+ * @return void
+ */
+
+void debugger_start (const struct program *p)
+{
+  debugged = p;
+  breaks   = calloc(p->lines_count + 1, 1);
+  watches  = calloc(p->variable_count + 1, 1);
+  watched  = calloc(p->variable_count + 1, sizeof *watched);
+  if (!breaks || !watches || !watched)
+  {
+    fprintf(stderr,
+      "*debugger.c: out of memory!\n");
+    exit(EXIT_FAILURE);
+  }
+  break_count = watch_count = 0;
+  /* Stop before the first line. */
+  stepping = 1;
+  update();
+}
+
+/**
+ * debugger_chain
+ *
+ * @param p The program CHAINed to, before its first line.
+ * @return void
+ */
+
+void debugger_chain (const struct program *p)
+{
+  char  *b, *w;
+  int   *v;
+  size_t i;
+  long   k;
+
+  b = calloc(p->lines_count + 1, 1);
+  w = calloc(p->variable_count + 1, 1);
+  v = calloc(p->variable_count + 1, sizeof *v);
+  if (!b || !w || !v)
+  {
+    fprintf(stderr,
+      "*debugger.c: out of memory!\n");
+    exit(EXIT_FAILURE);
+  }
+  /* Breakpoints carry over by line number, watchpoints by name,
+     as the variables do. */
+  break_count = watch_count = 0;
+  for (i = 0; i < debugged->lines_count; i++)
+    if (breaks[i] &&
+    (k = program_index(p, debugged->lines[i].number)) >= 0 && !b[k])
+    {
+      b[k] = 1;
+      break_count++;
+    }
+  for (i = 0; i < debugged->variable_count; i++)
+    if (watches[i] &&
+    (k = program_variable(p, program_name(debugged, (int) i))) >= 0)
+    {
+      w[k] = 1;
+      v[k] = watched[i];
+      watch_count++;
+    }
+  free(breaks);
+  free(watches);
+  free(watched);
+  breaks   = b;
+  watches  = w;
+  watched  = v;
+  debugged = p;
+  update();
+}
+
+/**
+ * debugger_stop
+ *
+ * @param void
+ * @return void
+ */
+
+void debugger_stop (void)
+{
+  stepping = break_count = watch_count = 0;
+  update();
+  free(breaks);
+  free(watches);
+  free(watched);
+  breaks  = NULL;
+  watches = NULL;
+  watched = NULL;
+}
\ No newline at end of file
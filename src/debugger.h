@@ -0,0 +1,17 @@
+/**************************************
+   debugger.h, @format.new-line  lf
+               @format.use-tabs  false
+   @format.tab-size    2
+   @format.indent-size 2
+   @format.line-length 80
+***************************************/
+#ifndef _DEBUGGER_H__
+#define _DEBUGGER_H__
+
+#include "program.h"
+
+void debugger_start (const struct program *p);
+void debugger_chain (const struct program *p);
+void debugger_stop  (void);
+
+#endif /* _DEBUGGER_H__ */
\ No newline at end of file
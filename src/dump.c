@@ -0,0 +1,179 @@
+/**********************************
+   dump.c, @format.new-line  lf
+           @format.use-tabs  false
+   @format.tab-size    2
+   @format.indent-size 2
+   @format.line-length 80
+***********************************/
+/* mmap is POSIX, not ANSI. */
+#ifdef VVTBI_POSIX
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#ifdef VVTBI_POSIX
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#endif
+
+#include "io.h"
+#include "tokenizer.h"
+#include "program.h"
+#include "dump.h"
+
+/* The amount of tokens written at a time. */
+#define DUMP_BLOCK 4096
+
+/* The tokens waiting to be written. */
+static struct dump_token block[DUMP_BLOCK];
+
+/******************************************************************************/
+
+/**
+ * token_length
+ *
+ * @param p The program.
+ * @param i The index of the token.
+ * @return n The length of the token's text.
+ */
+
+static unsigned int token_length (const struct program *p, size_t i)
+{
+  long start, end;
+  start = p->tokens[i].offset;
+  end   = i + 1 < p->count ? p->tokens[i + 1].offset : start;
+  /* A token runs up to the next, less the blanks between. */
+  while (end > start &&
+  (p->source[end - 1] == ' ' || p->source[end - 1] == '\t'))
+    end--;
+  return end > start ? (unsigned int) (end - start) : 0;
+}
+
+/**
+ * dump_tokens
+ *
+ * @param p The program.
+ * @param out The stream to write the dump to.
+ * @return Was the dump written?
+ */
+
+int dump_tokens (const struct program *p, FILE *out)
+{
+  struct dump_header header;
+  struct dump_token *t;
+  size_t             i, n;
+
+  memcpy(header.magic, VVTBI_DUMP_MAGIC, 4);
+  header.version = VVTBI_DUMP_VERSION;
+  header.order   = VVTBI_DUMP_ORDER;
+  header.record  = sizeof *block;
+  header.count   = (unsigned int) p->count;
+  header.source  = (unsigned int) p->length;
+  header.hash    = (unsigned int) p->hash;
+  header.strings = (unsigned int) p->strings_size;
+  fwrite(&header, sizeof header, 1, out);
+  /* Pack the tokens a block at a time. */
+  for (i = 0, n = 0; i < p->count; i++)
+  {
+    t          = &block[n++];
+    t->type    = (unsigned int) p->tokens[i].token;
+    t->offset  = (unsigned int) p->tokens[i].offset;
+    t->length  = token_length(p, i);
+    t->operand = p->tokens[i].value;
+    if (n == DUMP_BLOCK)
+    {
+      fwrite(block, sizeof *block, n, out);
+      n = 0;
+    }
+  }
+  fwrite(block, sizeof *block, n, out);
+  fwrite(p->strings, 1, p->strings_size, out);
+  fflush(out);
+  return !ferror(out);
+}
+
+/**
+ * dump_open
+ *
+ * @param d The dump to map.
+ * @param file The dump file.
+ * @return Was the file mapped, and is it a dump?
+ */
+
+int dump_open (struct dump *d, const char *file)
+{
+  const struct dump_header *h;
+  void                     *map;
+#ifdef VVTBI_POSIX
+  struct stat               st;
+  int                       fd;
+#endif
+
+  memset(d, 0, sizeof *d);
+#ifdef VVTBI_POSIX
+  if ((fd = open(file, O_RDONLY)) < 0)
+  {
+    fprintf(stderr,
+      "*dump.c: file `%s' failed!\n",
+      file);
+    return 0;
+  }
+  map = MAP_FAILED;
+  if (!fstat(fd, &st) && st.st_size >= (off_t) sizeof *h)
+    map = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED)
+  {
+    fprintf(stderr,
+      "*dump.c: file `%s' cannot be mapped\n",
+      file);
+    return 0;
+  }
+  d->size = (size_t) st.st_size;
+#else
+  /* Without mmap, the dump is read into memory instead. */
+  if (!(map = io_read(file, &d->size)))
+    return 0;
+#endif
+  d->header = h = map;
+  /* The tokens are read in place: they must be in our layout. */
+  if (d->size < sizeof *h ||
+  memcmp(h->magic, VVTBI_DUMP_MAGIC, 4) ||
+  h->version != VVTBI_DUMP_VERSION ||
+  h->order != VVTBI_DUMP_ORDER ||
+  h->record != sizeof *d->tokens ||
+  (d->size - sizeof *h) / sizeof *d->tokens < h->count ||
+  d->size - sizeof *h - h->count * sizeof *d->tokens < h->strings)
+  {
+    fprintf(stderr,
+      "*dump.c: file `%s' is not a token dump\n",
+      file);
+    dump_close(d);
+    return 0;
+  }
+  d->tokens  = (const struct dump_token *) (h + 1);
+  d->strings = (const char *) (d->tokens + h->count);
+  return 1;
+}
+
+/**
+ * dump_close
+ *
+ * @param d The dump to unmap.
+ * @return void
+ */
+
+void dump_close (struct dump *d)
+{
+#ifdef VVTBI_POSIX
+  if (d->header)
+    munmap((void *) d->header, d->size);
+#else
+  free((void *) d->header);
+#endif
+  memset(d, 0, sizeof *d);
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+/**********************************
+   dump.h, @format.new-line  lf
+           @format.use-tabs  false
+   @format.tab-size    2
+   @format.indent-size 2
+   @format.line-length 80
+***********************************/
+#ifndef _DUMP_H__
+#define _DUMP_H__
+
+#include <stdio.h>
+
+#include "program.h"
+
+/* The token dump format, see dump_tokens: a header, the
+   tokens and the string pool, in the writer's byte order. */
+#define VVTBI_DUMP_MAGIC   "VVTK"
+#define VVTBI_DUMP_VERSION 1
+#define VVTBI_DUMP_ORDER   0x01020304U
+
+/* The dump's header, 32 bytes. */
+struct dump_header {
+  char         magic[4];
+  unsigned int version;
+  unsigned int order;
+  unsigned int record;
+  unsigned int count;
+  unsigned int source;
+  unsigned int hash;
+  unsigned int strings;
+};
+
+/* A token, 16 bytes: its type, where it is in the source
+   and its operand: the number, the variable's cell location
+   or the offset of the string in the string pool. */
+struct dump_token {
+  unsigned int type;
+  unsigned int offset;
+  unsigned int length;
+  int          operand;
+};
+
+/* A dump, mapped (or, without POSIX, read) into memory by dump_open. */
+struct dump {
+  const struct dump_header *header;
+  const struct dump_token  *tokens;
+  const char               *strings;
+  size_t                    size;
+};
+
+int  dump_tokens (const struct program *p, FILE *out);
+int  dump_open   (struct dump *d, const char *file);
+void dump_close  (struct dump *d);
+
+#endif /* _DUMP_H__ */
\ No newline at end of file
@@ -0,0 +1,164 @@
+/***********************************
+   input.c, @format.new-line  lf
+            @format.use-tabs  false
+   @format.tab-size    2
+   @format.indent-size 2
+   @format.line-length 80
+************************************/
+/* open, read and close are POSIX, not ANSI. */
+#ifdef VVTBI_POSIX
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#ifdef VVTBI_POSIX
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "config.h"
+#include "input.h"
+#include "output.h"
+
+/* What INPUT reads from: standard input, unless opened; without
+   POSIX, through stdio, standard input being NULL. */
+#ifdef VVTBI_POSIX
+static int   source = STDIN_FILENO;
+#else
+static FILE *source = NULL;
+#endif
+
+/* The block read last, and what of it is yet to be parsed. */
+static char        block[VVTBI_INPUT_BUFFER];
+static const char *head = block;
+static const char *tail = block;
+
+/* Has the input ended? */
+static int ended = 0;
+
+/******************************************************************************/
+
+/**
+ * fill
+ *
+ * @param void
+ * @return Was another block read?
+ */
+
+static int fill (void)
+{
+#ifdef VVTBI_POSIX
+  ssize_t n;
+#else
+  size_t  n;
+#endif
+  if (ended)
+    return 0;
+  /* A prompt printed is seen before the wait. */
+  output_flush();
+#ifdef VVTBI_POSIX
+  while ((n = read(source, block, sizeof block)) < 0 && errno == EINTR)
+    ;
+  if (n <= 0)
+#else
+  /* A line at a time, not to wait on a terminal for a block. */
+  n = fgets(block, sizeof block, source ? source : stdin) ?
+    strlen(block) : 0;
+  if (!n)
+#endif
+  {
+    ended = 1;
+    return 0;
+  }
+  head = block;
+  tail = block + n;
+  return 1;
+}
+
+/**
+ * input_open
+ *
+ * @param filename The file INPUT is to read from.
+ * @return Was it opened?
+ */
+
+int input_open (const char *filename)
+{
+#ifdef VVTBI_POSIX
+  int   fd;
+  if ((fd = open(filename, O_RDONLY)) < 0)
+    return 0;
+#else
+  FILE *fd;
+  if (!(fd = fopen(filename, "r")))
+    return 0;
+#endif
+  input_close();
+  source = fd;
+  return 1;
+}
+
+/**
+ * input_number
+ *
+ * @param number Destination of the next number in the input.
+ * @return Was there one? If not, the input has ended.
+ */
+
+int input_number (long *number)
+{
+  const char   *c;
+  unsigned long value;
+  int           negative, digits;
+
+  /* Anything but digits separates numbers; a - just before
+     one makes it negative. A number may span blocks. */
+  for (value = 0, negative = digits = 0;; head = c)
+  {
+    if (head == tail && !fill())
+      break;
+    for (c = head; c < tail && !digits; c++)
+    {
+      if (*c >= '0' && *c <= '9')
+        break;
+      negative = *c == '-';
+    }
+    /* Digits are contiguous in every character set. */
+    for (; c < tail && *c >= '0' && *c <= '9'; c++, digits++)
+      value = value * 10 + (unsigned long) (*c - '0');
+    if (c < tail && digits)
+    {
+      head = c;
+      break;
+    }
+  }
+  if (!digits)
+    return 0;
+  *number = negative ? -(long) value : (long) value;
+  return 1;
+}
+
+/**
+ * input_close
+ *
+ * @param void
+ * @return void
+ */
+
+void input_close (void)
+{
+#ifdef VVTBI_POSIX
+  if (source != STDIN_FILENO)
+    close(source);
+  source = STDIN_FILENO;
+#else
+  if (source)
+    fclose(source);
+  source = NULL;
+#endif
+  head   = tail = block;
+  ended  = 0;
+}
\ No newline at end of file
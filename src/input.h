@@ -0,0 +1,15 @@
+/***********************************
+   input.h, @format.new-line  lf
+            @format.use-tabs  false
+   @format.tab-size    2
+   @format.indent-size 2
+   @format.line-length 80
+************************************/
+#ifndef _INPUT_H__
+#define _INPUT_H__
+
+int  input_open   (const char *filename);
+int  input_number (long *number);
+void input_close  (void);
+
+#endif /* _INPUT_H__ */
\ No newline at end of file
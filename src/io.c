@@ -5,17 +5,36 @@
    @format.indent-size 2
    @format.line-length 80
 *********************************/
+/* read and write are POSIX, not ANSI. */
+#ifdef VVTBI_POSIX
+#define _POSIX_C_SOURCE 200809L
+#endif
+
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
 
+#ifdef VVTBI_POSIX
+#include <unistd.h>
+#endif
+
 #include "io.h"
+#include "stats.h"
 
 /* The API file location. */
 static const char *file;
 
-/* The API file-handle. */
-static FILE *Handle = NULL;
+/* The API source text, read whole. */
+static const char *text = NULL;
+
+/* The length of the source text. */
+static size_t length = 0;
+
+/* Was the source text allocated by io_init? */
+static char *owned = NULL;
+
+/* The position of the current character in the source text. */
+static size_t position = 0;
 
 /* The API current character in stream. */
 static int current  = 0;
@@ -23,28 +42,100 @@ static int current  = 0;
 /* The next character in stream. */
 static int next     = 0;
 
+/* Has io_next yet to be used since io_reset? */
+static int fresh    = 1;
+
 /******************************************************************************/
 
 /**
- * io_init
+ * io_read
  *
- * @param fl The initial file for the API.
- * @return void
+ * @param filename The file to read.
+ * @param n Destination of the amount of characters read.
+ * @return buffer The whole file, null-terminated, or NULL.
  */
 
-void io_init (const char *filename)
+char *io_read (const char *filename, size_t *n)
 {
-  file   = filename;
-  Handle = fopen(file, "r");
+  FILE   *handle;
+  char   *buffer, *larger;
+  size_t  size, r;
+
+  handle = fopen(filename, "rb");
   /* Fopen failed! */
-  if (!Handle)
+  if (!handle)
   {
     fprintf(stderr,
       "*io.c: file `%s' failed!\n",
-      file);
-    /* Terminate program. */
-    exit(EXIT_FAILURE);
+      filename);
+    return NULL;
+  }
+  size   = 4096;
+  *n     = 0;
+  buffer = malloc(size);
+  stats.allocations++;
+  /* Read in large blocks, doubling the buffer as needed. */
+  while (buffer)
+  {
+    r   = fread(buffer + *n, 1, size - *n - 1, handle);
+    *n += r;
+    if (*n + 1 < size)
+      break;
+    size  *= 2;
+    larger = realloc(buffer, size);
+    stats.allocations++;
+    if (!larger)
+      free(buffer);
+    buffer = larger;
   }
+  fclose(handle);
+  if (!buffer)
+  {
+    fprintf(stderr,
+      "*io.c: file `%s' is too large!\n",
+      filename);
+    return NULL;
+  }
+  buffer[*n] = 0;
+  return buffer;
+}
+
+/**
+ * io_init
+ *
+ * @param fl The initial file for the API.
+ * @return void
+ */
+
+void io_init (const char *filename)
+{
+  size_t n;
+  owned = io_read(filename, &n);
+  /* Terminate program. */
+  if (!owned)
+    exit(EXIT_FAILURE);
+  io_buffer(filename, owned, n);
+  /* io_buffer forgets ownership; this stream is ours to free. */
+  owned = (char *) text;
+}
+
+/**
+ * io_buffer
+ *
+ * @param filename The name to report for the source text.
+ * @param source The source text, which must outlive the stream.
+ * @param n The length of the source text.
+ * @return void
+ */
+
+void io_buffer (const char *filename, const char *source, size_t n)
+{
+  file     = filename;
+  text     = source;
+  length   = n;
+  owned    = NULL;
+  position = 0;
+  fresh    = 1;
   io_next();
 }
 
@@ -69,7 +160,7 @@ int io_current (void)
 
 void io_reset (void)
 {
-  current = 0;
+  fresh = 1;
 }
 
 /**
@@ -81,18 +172,32 @@ void io_reset (void)
 
 void io_next (void)
 {
-  /* If io_next hasn't been used, set both current and next. */
-  if (!current)
-  {
-    current = getc(Handle);
-    next    = getc(Handle);
-  }
-  /* Otherwise, set current to next and retrieve the next character. */
-  else
-  {
-    current = next;
-    next    = getc(Handle);
-  }
+  /* If io_next hasn't been used, start at the current position.
+     Otherwise, move past the current character. */
+  if (!fresh && position < length)
+    position++;
+  fresh   = 0;
+  current = position < length ?
+    (unsigned char) text[position] : EOF;
+  next    = position + 1 < length ?
+    (unsigned char) text[position + 1] : EOF;
+}
+
+/**
+ * io_skip_line
+ *
+ * @param void
+ * @return void
+ */
+
+void io_skip_line (void)
+{
+  /* Scan the text directly, rather than a character per io_next. */
+  while (position < length &&
+  text[position] != '\r' && text[position] != '\n')
+    position++;
+  fresh = 1;
+  io_next();
 }
 
 /**
@@ -111,26 +216,33 @@ int io_peek (void)
  * io_location
  *
  * @param void
- * @return ftell
+ * @return position The offset of the current character.
  */
 
 long io_location (void)
 {
-  return ftell(Handle);
+  return (long) position;
 }
 
 /**
  * io_seek
  *
- * @param offset The offset in the file stream.
+ * @param offset The offset in the source text.
  * @param whence The initial location for offset.
- * @return fseek
+ * @return void
  */
 
 void io_seek (long offset, int whence)
 {
-  fseek(Handle, offset, whence);
-
+  if (whence == SEEK_CUR)
+    offset += (long) position;
+  else if (whence == SEEK_END)
+    offset += (long) length;
+  if (offset < 0)
+    offset = 0;
+  position = (size_t) offset > length ? length : (size_t) offset;
+  fresh    = 1;
+  io_next();
 }
 
 /**
@@ -170,44 +282,47 @@ void to_string (char *dest, size_t n)
 }
 
 /**
- * io_set
- *
- * @param f File to update API.
- * @param handle File-handle to update API.
- * @return void
- */
-
-void io_set (const char *filename, FILE *handle)
-{
-  /* Close the current stream. */
-  if (Handle)
-    io_close();
-  file   = filename;
-  Handle = handle;
-}
-
-/**
- * io_handle
+ * io_file
  *
  * @param void
- * @return Handle The current file-handle object.
+ * @return file The current file.
  */
 
-FILE *io_handle (void)
+const char *io_file (void)
 {
-  return Handle;
+  return file;
 }
 
 /**
- * io_file
+ * io_transfer
  *
- * @param void
- * @return file The current file.
+ * @param fd The pipe.
+ * @param data The data to read or write.
+ * @param n The amount of data.
+ * @param writing Write to the pipe, rather than read?
+ * @return Was all of the data transferred? Never, without
+ *         POSIX: there are no pipes.
  */
 
-const char *io_file (void)
+int io_transfer (int fd, void *data, size_t n, int writing)
 {
-  return file;
+#ifdef VVTBI_POSIX
+  char   *p;
+  ssize_t r;
+  for (p = data; n > 0; p += r, n -= r)
+  {
+    r = writing ? write(fd, p, n) : read(fd, p, n);
+    if (r <= 0)
+      return 0;
+  }
+  return 1;
+#else
+  (void) fd;
+  (void) data;
+  (void) n;
+  (void) writing;
+  return 0;
+#endif
 }
 
 /**
@@ -219,5 +334,6 @@ const char *io_file (void)
 
 void io_close (void)
 {
-  fclose(Handle);
+  free(owned);
+  owned = NULL;
 }
\ No newline at end of file
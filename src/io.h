@@ -8,19 +8,21 @@
 #ifndef _IO_H__
 #define _IO_H__
 
+char       *io_read     (const char *filename, size_t *n);
 void        io_init     (const char *filename);
+void        io_buffer   (const char *filename, const char *source,
+                         size_t n);
 int         io_current  (void);
 void        io_next     (void);
-void        io_back     (void);
+void        io_skip_line(void);
 void        io_reset    (void);
 void        io_seek     (long offset, int whence);
 long        io_location (void);
 int         io_peek     (void);
 int         io_eof      (void);
 const char *io_file     (void);
-void        io_set      (const char *f, FILE *handle);
-FILE       *io_handle   (void);
 void        to_string   (char *dest, size_t n);
+int         io_transfer (int fd, void *data, size_t n, int writing);
 void        io_close    (void);
 
 #endif /* _IO_H__ */
\ No newline at end of file
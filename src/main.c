@@ -8,10 +8,24 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <time.h>
 
 #include "config.h"
 #include "tokenizer.h"
+#include "program.h"
 #include "vvtbi.h"
+#include "scheduler.h"
+#include "daemon.h"
+#include "sample.h"
+#include "perfctr.h"
+#include "stats.h"
+#include "trace.h"
+#include "debugger.h"
+#include "check.h"
+#include "repl.h"
+#include "dump.h"
+#include "output.h"
+#include "input.h"
 
 /* Vvtbi's version number. */
 #define VERSION "2.0"
@@ -19,8 +33,42 @@
 /* The message printed if no file is given. */
 #define NOARGS  "VERSION: " VERSION "\n"      \
   "***************************************\n" \
-  "  Howto: ./vvtbi [-debug] file."           \
-  VVTBI_EXTENSION_LITERAL "\n"
+  "  Howto: ./vvtbi [options] file."          \
+  VVTBI_EXTENSION_LITERAL " [file."            \
+  VVTBI_EXTENSION_LITERAL " ...]\n"
+
+/* The options, printed after NOARGS. */
+static const char *options[] =
+{
+  "  -debug                Run the scanner only.",
+  "  -dump-tokens=bin      Write the tokens, binary.",
+  "  -check                Check files, run nothing.",
+  "  -int64                Make every variable 64-bit.",
+  "  -async-output         Write PRINT's output on a thread.",
+  "  -input file           INPUT from file, not stdin.",
+  "  -watch                Rerun on edit, recompiling",
+  "                        only the lines edited.",
+  "  -repl [file]          Edit and run interactively.",
+  "  -snapshot line file   Snapshot before line.",
+  "  -restore file         Resume a snapshot.",
+  "  -record-profile file  Record line counts.",
+  "  -use-profile file     Optimize by a profile.",
+  "  -sample file          Sample to folded stacks.",
+  "  -perfctr              Count cycles and misses.",
+  "  -stats[=json]         Report run statistics.",
+  "  -trace file           Trace the last lines run.",
+  "  -trace-decode file    Print a trace.",
+  "  -debugger             Run under the debugger.",
+  "  -client               Run on vvtbid, if it runs.",
+  "  -daemon               Serve runs, as vvtbid.",
+  NULL
+};
+
+/* The profile file recorded, or NULL. */
+static const char *record = NULL;
+
+/* Are the counters, and the debugger, running? */
+static int perfctr = 0, debugger = 0;
 
 /******************************************************************************/
 
@@ -41,52 +89,333 @@ int valid(const char *filename)
   VVTBI_EXTENSION_LITERAL) == 0;
 }
 
+/**
+ * usage
+ *
+ * @param void
+ * @return void
+ */
+
+void usage (void)
+{
+  const char **option;
+  printf(NOARGS);
+  for (option = options; *option; option++)
+    printf("%s\n", *option);
+}
+
+/**
+ * run_context
+ *
+ * @param source Source code file.
+ * @param line Line number to snapshot before, or -1.
+ * @param save The snapshot file to write.
+ * @param restore The snapshot file to resume, or NULL.
+ * @return Did the script run?
+ */
+
+int run_context (const char *source, int line,
+  const char *save, const char *restore)
+{
+  struct vvtbi_context ctx;
+  FILE                *handle;
+  int                  ok;
+
+  vvtbi_context(&ctx, source);
+  /* Skip straight to the snapshot. */
+  if (restore)
+  {
+    if (!(handle = fopen(restore, "rb")))
+    {
+      fprintf(stderr,
+        "*main.c: file `%s' failed!\n",
+        restore);
+      return 0;
+    }
+    ok = vvtbi_restore(&ctx, handle);
+    fclose(handle);
+    if (!ok) return 0;
+  }
+  /* Run line by line until the snapshot's line is next. */
+  if (save)
+  {
+    while (!ctx.finished && vvtbi_line(&ctx) != line)
+      vvtbi_step(&ctx, 1);
+    if (!(handle = fopen(save, "wb")))
+    {
+      fprintf(stderr,
+        "*main.c: file `%s' failed!\n",
+        save);
+      return 0;
+    }
+    ok = vvtbi_snapshot(&ctx, handle);
+    fclose(handle);
+    if (!ok) return 0;
+  }
+  /* Run the remainder. */
+  while (!ctx.finished)
+    vvtbi_step(&ctx, VVTBI_SCHEDULER_BUDGET);
+  vvtbi_release(&ctx);
+  return 1;
+}
+
+/**
+ * chained
+ *
+ * @param from The program run.
+ * @param to The program CHAINed to.
+ * @return void
+ */
+
+static void chained (const struct program *from,
+  const struct program *to)
+{
+  /* Each program counted is reported in turn. */
+  if (perfctr)
+  {
+    perfctr_write(from, stderr);
+    perfctr_lines(to->lines_count);
+  }
+  if (debugger)
+    debugger_chain(to);
+  /* A profile is used with the file it was recorded from: that
+     run first. */
+  if (record)
+  {
+    vvtbi_profile(NULL);
+    if (!profile_write(record))
+      exit(EXIT_FAILURE);
+    record = NULL;
+  }
+}
+
 /******************/
 /* Start program. */
 /******************/
 
 int main (int argc, char **argv)
 {
-  if (argc < 2)
-  {
-    /* No args, print message. */
-    printf(NOARGS);
-  }
-  /* Debug mode, run and print scanner only. */
-  else if (!strcmp(argv[1], "-debug"))
+  const char *save, *restore, *use, *sample, *name;
+  int         i, j, debug, line, report, check;
+  int         watch, dump, client, async, status;
+  clock_t     start;
+
+  save    = restore = use = sample = NULL;
+  debug   = report = check = watch = dump = client = 0;
+  async   = 0;
+  line    = -1;
+  /* Run as vvtbid, the daemon. */
+  name = strrchr(argv[0], '/');
+  if (!strcmp(name ? name + 1 : argv[0], "vvtbid"))
+    return daemon_run() ? EXIT_SUCCESS : EXIT_FAILURE;
+  /* Parse options. */
+  for (i = 1; i < argc && argv[i][0] == '-'; i++)
   {
-    if (argc < 3)
+    if (!strcmp(argv[i], "-debug"))
+      debug = 1;
+    else if (!strcmp(argv[i], "-dump-tokens=bin"))
+      dump = 1;
+    else if (!strcmp(argv[i], "-check"))
+      check = 1;
+    /* Only where a long is 64-bit; else it is not an option. */
+    else if (!strcmp(argv[i], "-int64") && sizeof (long) >= 8)
+      program_wide = 1;
+    else if (!strcmp(argv[i], "-async-output"))
+      async = 1;
+    else if (!strcmp(argv[i], "-input") && i + 1 < argc)
     {
-      printf(NOARGS);
+      if (!input_open(argv[++i]))
+      {
+        fprintf(stderr, "*main.c: file `%s' failed!\n", argv[i]);
+        return EXIT_FAILURE;
+      }
     }
+    else if (!strcmp(argv[i], "-watch"))
+      watch = 1;
+    else if (!strcmp(argv[i], "-repl"))
+      return (i + 1 == argc || valid(argv[i + 1])) &&
+        repl_run(i + 1 < argc ? argv[i + 1] : NULL) ?
+        EXIT_SUCCESS : EXIT_FAILURE;
+    else if (!strcmp(argv[i], "-snapshot") && i + 2 < argc)
+    {
+      line = atoi(argv[++i]);
+      save = argv[++i];
+    }
+    else if (!strcmp(argv[i], "-restore") && i + 1 < argc)
+      restore = argv[++i];
+    else if (!strcmp(argv[i], "-record-profile") && i + 1 < argc)
+      record = argv[++i];
+    else if (!strcmp(argv[i], "-use-profile") && i + 1 < argc)
+      use = argv[++i];
+    else if (!strcmp(argv[i], "-sample") && i + 1 < argc)
+      sample = argv[++i];
+    else if (!strcmp(argv[i], "-perfctr"))
+      perfctr = 1;
+    else if (!strcmp(argv[i], "-debugger"))
+      debugger = 1;
+    else if (!strcmp(argv[i], "-stats"))
+      report = 1;
+    else if (!strcmp(argv[i], "-stats=json"))
+      report = 2;
+    else if (!strcmp(argv[i], "-trace") && i + 1 < argc)
+    {
+      if (!trace_start(argv[++i]))
+        return EXIT_FAILURE;
+    }
+    else if (!strcmp(argv[i], "-trace-decode") && i + 1 < argc)
+      return trace_decode(argv[i + 1], stdout) ?
+        EXIT_SUCCESS : EXIT_FAILURE;
+    else if (!strcmp(argv[i], "-client"))
+      client = 1;
+    else if (!strcmp(argv[i], "-daemon"))
+      return daemon_run() ? EXIT_SUCCESS : EXIT_FAILURE;
     else
     {
-      /* Check file type. */
-      if (!valid(argv[2])) return EXIT_FAILURE;
-
-      tokenizer_init(argv[2]);
-      /* Run scanner until EOF. */
-      do {
-        /* Print token string. */
-        printf("%s ", vvtbi_token(tokenizer_token()));
-        if (tokenizer_token() == T_EOL)
-          printf("\n");
-        tokenizer_next();
-      } while (!tokenizer_finished());
+      usage();
+      return EXIT_FAILURE;
     }
   }
+
+  if (i >= argc)
+  {
+    /* No args, print message. */
+    usage();
+    return EXIT_SUCCESS;
+  }
+
+  /* Check file types. */
+  for (j = i; j < argc; j++)
+    if (!valid(argv[j])) return EXIT_FAILURE;
+
+  /* Client mode, a single file alone: forward the run to
+     vvtbid if it is running, else run it here. */
+  if (client && (i != 2 || argc != 3))
+  {
+    usage();
+    return EXIT_FAILURE;
+  }
+  if (client && daemon_forward(argv[i], &status))
+    return status;
+
+  /* Check mode, report every error in every file. */
+  if (check)
+    return check_files(argv + i, argc - i) ?
+      EXIT_SUCCESS : EXIT_FAILURE;
+
+  /* Dump mode, write the tokens for other tools. */
+  if (dump)
+    return dump_tokens(program_load(argv[i]), stdout) ?
+      EXIT_SUCCESS : EXIT_FAILURE;
+
+  /* Watch mode, rerun on every edit. */
+  if (watch)
+    return repl_watch(argv[i]) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+  /* The tools attach to a single interpreter: a snapshot
+     or the scheduler's would run without them. */
+  if (!debug && (save || restore || argc - i > 1) &&
+  (report || perfctr || sample || debugger || record || use))
+  {
+    usage();
+    return EXIT_FAILURE;
+  }
+
+  /* Without a thread, output is printed as it always was. With
+     one, a CHAIN's load mustn't fork beside it. */
+  if (async && !debug)
+  {
+    if (output_start())
+      program_parallel = 0;
+    else
+      fprintf(stderr, "*main.c: async output is unavailable\n");
+  }
+
+  /* Debug mode, run and print scanner only. */
+  if (debug)
+  {
+    tokenizer_init(argv[i]);
+    /* Run scanner until EOF. */
+    do {
+      /* Print token string. */
+      printf("%s ", vvtbi_token(tokenizer_token()));
+      if (tokenizer_token() == T_EOL)
+        printf("\n");
+      tokenizer_next();
+    } while (!tokenizer_finished());
+  }
+  /* Run from, or up to, a snapshot. */
+  else if (save || restore)
+  {
+    if (!run_context(argv[i], line, save, restore))
+      return EXIT_FAILURE;
+  }
+  /* Run many interpreters, round-robin. */
+  else if (argc - i > 1)
+  {
+    struct scheduler s;
+
+    scheduler_init(&s);
+    for (j = i; j < argc; j++)
+      scheduler_add(&s, argv[j], VVTBI_SCHEDULER_BUDGET);
+    /* Run interpreters until every one is finished. */
+    scheduler_run(&s);
+    scheduler_free(&s);
+  }
   /* Run interpreter. */
   else
   {
-    /* Check file type. */
-    if (!valid(argv[1])) return EXIT_FAILURE;
-
-    vvtbi_init(argv[1]);
+    /* Sampling starts before loading, to sample the scanner. */
+    if (sample && !sample_start())
+    {
+      fprintf(stderr, "*main.c: sampling is unavailable\n");
+      sample = NULL;
+    }
+    /* Without counters, run as normal. */
+    if (perfctr)
+      perfctr = perfctr_open();
+    start = clock();
+    vvtbi_init(argv[i]);
+    stats.load = clock() - start;
+    if (sample)
+      sample_lines(vvtbi_program()->lines_count);
+    if (perfctr)
+    {
+      perfctr_lines(vvtbi_program()->lines_count);
+      vvtbi_hook(perfctr_line);
+    }
+    if (debugger)
+      debugger_start(vvtbi_program());
+    if (use && !profile_use(vvtbi_program(), use))
+      return EXIT_FAILURE;
+    if (record)
+      vvtbi_profile(profile_start(vvtbi_program()));
+    vvtbi_chained(chained);
     /* Run interpreter until EOF. */
+    start = clock();
     do {
       vvtbi_run();
     } while (!vvtbi_finished());
-
+    stats.run = clock() - start;
+    if (debugger)
+      debugger_stop();
+    if (record && !profile_write(record))
+      return EXIT_FAILURE;
+    if (report)
+    {
+      output_flush();
+      stats_write(stderr, report == 2);
+    }
+    if (perfctr)
+    {
+      perfctr_write(vvtbi_program(), stderr);
+      perfctr_close();
+    }
+    if (sample)
+    {
+      sample_stop();
+      if (!sample_write(vvtbi_program(), sample))
+        return EXIT_FAILURE;
+    }
   }
   /* Complete! :) */
   return EXIT_SUCCESS;
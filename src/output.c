@@ -0,0 +1,249 @@
+/************************************
+   output.c, @format.new-line  lf
+             @format.use-tabs  false
+   @format.tab-size    2
+   @format.indent-size 2
+   @format.line-length 80
+*************************************/
+/* Threads, write and vsnprintf are POSIX, not ANSI: without
+   them, PRINT's output is printed as it was. */
+#ifdef VVTBI_POSIX
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <signal.h>
+#ifdef VVTBI_POSIX
+#include <unistd.h>
+#include <pthread.h>
+#endif
+
+#include "config.h"
+#include "output.h"
+
+#ifdef VVTBI_POSIX
+/* The buffers PRINT fills, in turn, and their lengths. */
+static char  *buffers[VVTBI_OUTPUT_BUFFERS];
+static size_t lengths[VVTBI_OUTPUT_BUFFERS];
+
+/* The buffer being filled; the first full buffer, and the
+   amount full, waiting for the writer. */
+static int filling = 0;
+static int head    = 0;
+static int queued  = 0;
+
+/* Is the writer running, and has it been asked to stop? */
+static int running  = 0;
+static int stopping = 0;
+
+/* The writer, and what it and the interpreter wait on. */
+static pthread_t       writer;
+static pthread_mutex_t lock  = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  ready = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t  freed = PTHREAD_COND_INITIALIZER;
+#endif
+
+/******************************************************************************/
+
+#ifdef VVTBI_POSIX
+/**
+ * drain
+ *
+ * @param data Unused.
+ * @return NULL
+ */
+
+static void *drain (void *data)
+{
+  const char *c;
+  size_t      n;
+  ssize_t     written;
+  int         i;
+
+  (void) data;
+  pthread_mutex_lock(&lock);
+  for (;;)
+  {
+    while (!queued && !stopping)
+      pthread_cond_wait(&ready, &lock);
+    if (!queued)
+      break;
+    i = head;
+    /* Write without the lock: the interpreter fills another. */
+    pthread_mutex_unlock(&lock);
+    for (c = buffers[i], n = lengths[i]; n; c += written, n -= written)
+      if ((written = write(STDOUT_FILENO, c, n)) < 0)
+      {
+        if (errno == EINTR)
+          written = 0;
+        /* A closed pipe: the output is lost, as printf's is. */
+        else
+          break;
+      }
+    pthread_mutex_lock(&lock);
+    lengths[i] = 0;
+    head       = (head + 1) % VVTBI_OUTPUT_BUFFERS;
+    queued--;
+    pthread_cond_broadcast(&freed);
+  }
+  pthread_mutex_unlock(&lock);
+  return NULL;
+}
+
+/**
+ * hand_off
+ *
+ * @param void
+ * @return void
+ */
+
+static void hand_off (void)
+{
+  pthread_mutex_lock(&lock);
+  /* Block only when every other buffer is full. */
+  while (queued == VVTBI_OUTPUT_BUFFERS - 1)
+    pthread_cond_wait(&freed, &lock);
+  queued++;
+  filling = (filling + 1) % VVTBI_OUTPUT_BUFFERS;
+  pthread_cond_signal(&ready);
+  pthread_mutex_unlock(&lock);
+}
+#endif
+
+/**
+ * output_start
+ *
+ * @param void
+ * @return Did the writer start? If not, output is printed as it was.
+ */
+
+int output_start (void)
+{
+#ifdef VVTBI_POSIX
+  sigset_t all, old;
+  int      i, ok;
+
+  if (running)
+    return 1;
+  for (i = 0; i < VVTBI_OUTPUT_BUFFERS; i++)
+  {
+    if (!buffers[i] && !(buffers[i] = malloc(VVTBI_OUTPUT_BUFFER)))
+      return 0;
+    lengths[i] = 0;
+  }
+  /* What is printed already goes first. */
+  fflush(stdout);
+  filling  = head = queued = 0;
+  stopping = 0;
+  /* Signals, SIGPROF say, are for the interpreter's thread. */
+  sigfillset(&all);
+  pthread_sigmask(SIG_BLOCK, &all, &old);
+  ok = !pthread_create(&writer, NULL, drain, NULL);
+  pthread_sigmask(SIG_SETMASK, &old, NULL);
+  if (!ok)
+    return 0;
+  running = 1;
+  atexit(output_stop);
+  return 1;
+#else
+  return 0;
+#endif
+}
+
+/**
+ * output_print
+ *
+ * @param format Message format.
+ * @param ... Additional arguments.
+ * @return n The amount of characters printed.
+ */
+
+int output_print (const char *format, ...)
+{
+  va_list args;
+#ifdef VVTBI_POSIX
+  size_t  room;
+#endif
+  int     n;
+
+  va_start(args, format);
+#ifdef VVTBI_POSIX
+  if (!running)
+#endif
+  {
+    n = vprintf(format, args);
+    va_end(args);
+    return n;
+  }
+#ifdef VVTBI_POSIX
+  room = VVTBI_OUTPUT_BUFFER - lengths[filling];
+  n    = vsnprintf(buffers[filling] + lengths[filling], room, format, args);
+  va_end(args);
+  /* Too long for what is left: print into the next buffer. */
+  if (n >= 0 && (size_t) n >= room)
+  {
+    hand_off();
+    va_start(args, format);
+    n = vsnprintf(buffers[filling], VVTBI_OUTPUT_BUFFER, format, args);
+    va_end(args);
+    if (n >= VVTBI_OUTPUT_BUFFER)
+      n = VVTBI_OUTPUT_BUFFER - 1;
+  }
+  if (n > 0)
+    lengths[filling] += (size_t) n;
+  return n;
+#endif
+}
+
+/**
+ * output_flush
+ *
+ * @param void
+ * @return void
+ */
+
+void output_flush (void)
+{
+#ifdef VVTBI_POSIX
+  if (!running)
+#endif
+  {
+    fflush(stdout);
+    return;
+  }
+#ifdef VVTBI_POSIX
+  if (lengths[filling])
+    hand_off();
+  /* Wait for the writer to write everything. */
+  pthread_mutex_lock(&lock);
+  while (queued)
+    pthread_cond_wait(&freed, &lock);
+  pthread_mutex_unlock(&lock);
+#endif
+}
+
+/**
+ * output_stop
+ *
+ * @param void
+ * @return void
+ */
+
+void output_stop (void)
+{
+#ifdef VVTBI_POSIX
+  if (!running)
+    return;
+  output_flush();
+  pthread_mutex_lock(&lock);
+  stopping = 1;
+  pthread_cond_signal(&ready);
+  pthread_mutex_unlock(&lock);
+  pthread_join(writer, NULL);
+  running = 0;
+#endif
+}
\ No newline at end of file
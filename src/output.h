@@ -0,0 +1,16 @@
+/************************************
+   output.h, @format.new-line  lf
+             @format.use-tabs  false
+   @format.tab-size    2
+   @format.indent-size 2
+   @format.line-length 80
+*************************************/
+#ifndef _OUTPUT_H__
+#define _OUTPUT_H__
+
+int  output_start (void);
+int  output_print (const char *format, ...);
+void output_flush (void);
+void output_stop  (void);
+
+#endif /* _OUTPUT_H__ */
\ No newline at end of file
@@ -0,0 +1,290 @@
+/*************************************
+   perfctr.c, @format.new-line  lf
+              @format.use-tabs  false
+   @format.tab-size    2
+   @format.indent-size 2
+   @format.line-length 80
+**************************************/
+/* syscall is neither ANSI nor POSIX. */
+#define _GNU_SOURCE
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#include "perfctr.h"
+
+/* Counter names, as reported. */
+static const char *counter_strings[] =
+{
+  "cycles",
+  "instructions",
+  "branch-misses",
+  "L1d-misses"
+};
+
+/* The counters of a line, or of loading. */
+struct perfctr_count {
+  unsigned long runs;
+  double        counter[C_COUNTERS];
+};
+
+/* Each counter's file descriptor, or -1 if unavailable. */
+static int fds[C_COUNTERS] = { -1, -1, -1, -1 };
+
+/* The counters at the last read. */
+static double last[C_COUNTERS];
+
+/* The counters spent loading, before the first line. */
+static struct perfctr_count load;
+
+/* The counters spent per line, see perfctr_lines. */
+static struct perfctr_count *counts = NULL;
+
+/* The amount of lines counts has room for. */
+static size_t lines = 0;
+
+/* The line the counters since the last read belong to. */
+static long previous = -1;
+
+/******************************************************************************/
+
+#ifdef __linux__
+
+/**
+ * open_counter
+ *
+ * @param type The perf_event type.
+ * @param config The perf_event configuration.
+ * @param group The group leader's file descriptor, or -1.
+ * @return fd The counter's file descriptor, or -1.
+ */
+
+static int open_counter (__u32 type, __u64 config, int group)
+{
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof attr);
+  attr.size           = sizeof attr;
+  attr.type           = type;
+  attr.config         = config;
+  attr.disabled       = group == -1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv     = 1;
+  attr.read_format    = PERF_FORMAT_GROUP;
+  return (int) syscall(__NR_perf_event_open, &attr, 0, -1, group, 0);
+}
+
+/**
+ * read_counters
+ *
+ * @param now Destination of the counters' current values.
+ * @return void
+ */
+
+static void read_counters (double *now)
+{
+  __u64 values[C_COUNTERS + 1];
+  int   i, j;
+  /* One read of the group returns every counter opened, in order. */
+  if (read(fds[C_CYCLES], values, sizeof values) <= 0)
+    return;
+  for (i = 0, j = 1; i < C_COUNTERS; i++)
+    now[i] = fds[i] >= 0 ? (double) values[j++] : 0;
+}
+
+#endif
+
+/**
+ * perfctr_open
+ *
+ * @param void
+ * @return Were the counters opened?
+ */
+
+int perfctr_open (void)
+{
+#ifdef __linux__
+  int i;
+  fds[C_CYCLES] = open_counter(PERF_TYPE_HARDWARE,
+    PERF_COUNT_HW_CPU_CYCLES, -1);
+  if (fds[C_CYCLES] < 0)
+  {
+    fprintf(stderr,
+      "*perfctr.c: counters are unavailable (%s)\n",
+      strerror(errno));
+    return 0;
+  }
+  /* The remaining counters are optional members of the group. */
+  fds[C_INSTRUCTIONS]  = open_counter(PERF_TYPE_HARDWARE,
+    PERF_COUNT_HW_INSTRUCTIONS, fds[C_CYCLES]);
+  fds[C_BRANCH_MISSES] = open_counter(PERF_TYPE_HARDWARE,
+    PERF_COUNT_HW_BRANCH_MISSES, fds[C_CYCLES]);
+  fds[C_L1D_MISSES]    = open_counter(PERF_TYPE_HW_CACHE,
+    PERF_COUNT_HW_CACHE_L1D |
+    (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+    (PERF_COUNT_HW_CACHE_RESULT_MISS << 16), fds[C_CYCLES]);
+  for (i = 0; i < C_COUNTERS; i++)
+    if (fds[i] < 0)
+      fprintf(stderr,
+        "*perfctr.c: counter `%s' is unavailable\n",
+        counter_strings[i]);
+  memset(&load, 0, sizeof load);
+  memset(last, 0, sizeof last);
+  previous = -1;
+  ioctl(fds[C_CYCLES], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(fds[C_CYCLES], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  return 1;
+#else
+  fprintf(stderr,
+    "*perfctr.c: counters are unavailable on this platform\n");
+  return 0;
+#endif
+}
+
+/**
+ * perfctr_lines
+ *
+ * @param n The amount of lines in the program being counted.
+ * @return void
+ */
+
+void perfctr_lines (size_t n)
+{
+  free(counts);
+  counts = calloc(n + 1, sizeof *counts);
+  lines  = counts ? n : 0;
+}
+
+/**
+ * perfctr_line
+ *
+ * @param line The index of the line about to run, or -1.
+ * @return void
+ */
+
+void perfctr_line (int line)
+{
+#ifdef __linux__
+  struct perfctr_count *c;
+  double                now[C_COUNTERS];
+  int                   i;
+
+  if (fds[C_CYCLES] < 0)
+    return;
+  read_counters(now);
+  /* Everything since the last read belongs to the last line. */
+  c = previous >= 0 && (size_t) previous < lines ?
+    &counts[previous] : &load;
+  for (i = 0; i < C_COUNTERS; i++)
+  {
+    c->counter[i] += now[i] - last[i];
+    last[i]        = now[i];
+  }
+  if (line >= 0 && (size_t) line < lines)
+    counts[line].runs++;
+  previous = line;
+#else
+  (void) line;
+#endif
+}
+
+/**
+ * print_count
+ *
+ * @param out The stream to report to.
+ * @param c The counters to report.
+ * @return void
+ */
+
+static void print_count (FILE *out, const struct perfctr_count *c)
+{
+  int i;
+  for (i = 0; i < C_COUNTERS; i++)
+  {
+    if (fds[i] < 0)
+      fprintf(out, " %14s", "-");
+    else
+      fprintf(out, " %14.0f", c->counter[i]);
+  }
+  /* Instructions per cycle. */
+  if (fds[C_INSTRUCTIONS] >= 0 && c->counter[C_CYCLES] > 0)
+    fprintf(out, " %6.2f",
+      c->counter[C_INSTRUCTIONS] / c->counter[C_CYCLES]);
+  else
+    fprintf(out, " %6s", "-");
+  /* Misses per run of the line. */
+  if (c->runs && fds[C_BRANCH_MISSES] >= 0)
+    fprintf(out, " %10.2f",
+      c->counter[C_BRANCH_MISSES] / c->runs);
+  else
+    fprintf(out, " %10s", "-");
+  if (c->runs && fds[C_L1D_MISSES] >= 0)
+    fprintf(out, " %10.2f\n",
+      c->counter[C_L1D_MISSES] / c->runs);
+  else
+    fprintf(out, " %10s\n", "-");
+}
+
+/**
+ * perfctr_write
+ *
+ * @param p The program counted.
+ * @param out The stream to report to.
+ * @return void
+ */
+
+void perfctr_write (const struct program *p, FILE *out)
+{
+  size_t i;
+  int    j;
+
+  if (fds[C_CYCLES] < 0)
+    return;
+  /* Close the last line's count. */
+  perfctr_line(-1);
+  fprintf(out, "%-10s %10s", "line", "runs");
+  for (j = 0; j < C_COUNTERS; j++)
+    fprintf(out, " %14s", counter_strings[j]);
+  fprintf(out, " %6s %10s %10s\n", "IPC", "br-miss/run", "L1d-miss/run");
+  /* Loading, and any REM lines, belong to no numbered line. */
+  fprintf(out, "%-10s %10s", "(load)", "-");
+  print_count(out, &load);
+  for (i = 0; i < lines && i < p->lines_count; i++)
+  {
+    if (!counts[i].runs)
+      continue;
+    fprintf(out, "%-10d %10lu", p->lines[i].number, counts[i].runs);
+    print_count(out, &counts[i]);
+  }
+}
+
+/**
+ * perfctr_close
+ *
+ * @param void
+ * @return void
+ */
+
+void perfctr_close (void)
+{
+#ifdef __linux__
+  int i;
+  for (i = 0; i < C_COUNTERS; i++)
+    if (fds[i] >= 0)
+    {
+      close(fds[i]);
+      fds[i] = -1;
+    }
+#endif
+  free(counts);
+  counts = NULL;
+  lines  = 0;
+}
\ No newline at end of file
@@ -0,0 +1,28 @@
+/*************************************
+   perfctr.h, @format.new-line  lf
+              @format.use-tabs  false
+   @format.tab-size    2
+   @format.indent-size 2
+   @format.line-length 80
+**************************************/
+#ifndef _PERFCTR_H__
+#define _PERFCTR_H__
+
+#include "program.h"
+
+/* The hardware counters, in the order they are reported. */
+enum {
+  C_CYCLES,
+  C_INSTRUCTIONS,
+  C_BRANCH_MISSES,
+  C_L1D_MISSES,
+  C_COUNTERS
+};
+
+int  perfctr_open  (void);
+void perfctr_lines (size_t n);
+void perfctr_line  (int line);
+void perfctr_write (const struct program *p, FILE *out);
+void perfctr_close (void);
+
+#endif /* _PERFCTR_H__ */
\ No newline at end of file
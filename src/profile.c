@@ -0,0 +1,114 @@
+/*************************************
+   profile.c, @format.new-line  lf
+              @format.use-tabs  false
+   @format.tab-size    2
+   @format.indent-size 2
+   @format.line-length 80
+**************************************/
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "config.h"
+#include "profile.h"
+
+/* The program being recorded. */
+static const struct program *recorded = NULL;
+
+/* The recorded counts, one per line in the line table. */
+static struct profile_count *counts = NULL;
+
+/******************************************************************************/
+
+/**
+ * profile_start
+ *
+ * @param p The program to record.
+ * @return counts The zeroed counts, indexed by line.
+ */
+
+struct profile_count *profile_start (const struct program *p)
+{
+  free(counts);
+  recorded = p;
+  counts   = calloc(p->lines_count + 1, sizeof *counts);
+  if (!counts)
+  {
+    fprintf(stderr,
+      "*profile.c: out of memory!\n");
+    exit(EXIT_FAILURE);
+  }
+  return counts;
+}
+
+/**
+ * profile_write
+ *
+ * @param file The profile file to write.
+ * @return Was the profile written?
+ */
+
+int profile_write (const char *file)
+{
+  FILE  *handle;
+  size_t i;
+  int    ok;
+
+  if (!recorded)
+    return 0;
+  if (!(handle = fopen(file, "w")))
+  {
+    fprintf(stderr,
+      "*profile.c: file `%s' failed!\n",
+      file);
+    return 0;
+  }
+  /* One line per executed line: number, count, taken, not taken. */
+  for (i = 0; i < recorded->lines_count; i++)
+    if (counts[i].count)
+      fprintf(handle, "%d %lu %lu %lu\n",
+        recorded->lines[i].number,
+        counts[i].count,
+        counts[i].taken,
+        counts[i].not_taken);
+  ok = !ferror(handle);
+  fclose(handle);
+  return ok;
+}
+
+/**
+ * profile_use
+ *
+ * @param p The program to optimize.
+ * @param file The profile file to read.
+ * @return Was the profile read?
+ */
+
+int profile_use (struct program *p, const char *file)
+{
+  FILE          *handle;
+  unsigned long  count, taken, not_taken;
+  long           line;
+  int            number;
+
+  if (!(handle = fopen(file, "r")))
+  {
+    fprintf(stderr,
+      "*profile.c: file `%s' failed!\n",
+      file);
+    return 0;
+  }
+  while (fscanf(handle, "%d %lu %lu %lu",
+  &number, &count, &taken, &not_taken) == 4)
+  {
+    /* Resolve the jumps of hot lines ahead of time; an IF that was
+       never taken keeps to its fall-through and isn't resolved. */
+    if (count < VVTBI_PROFILE_HOT ||
+    (line = program_index(p, number)) < 0)
+      continue;
+    if (taken || !not_taken)
+      p->lines[line].target = program_jump(p, line);
+  }
+  fclose(handle);
+  return 1;
+}
\ No newline at end of file
@@ -0,0 +1,24 @@
+/*************************************
+   profile.h, @format.new-line  lf
+              @format.use-tabs  false
+   @format.tab-size    2
+   @format.indent-size 2
+   @format.line-length 80
+**************************************/
+#ifndef _PROFILE_H__
+#define _PROFILE_H__
+
+#include "program.h"
+
+/* The execution counts of a line; IF lines count their branch. */
+struct profile_count {
+  unsigned long count;
+  unsigned long taken;
+  unsigned long not_taken;
+};
+
+struct profile_count *profile_start (const struct program *p);
+int                   profile_write (const char *file);
+int                   profile_use   (struct program *p, const char *file);
+
+#endif /* _PROFILE_H__ */
\ No newline at end of file
@@ -0,0 +1,2638 @@
+/*************************************
+   program.c, @format.new-line  lf
+              @format.use-tabs  false
+   @format.tab-size    2
+   @format.indent-size 2
+   @format.line-length 80
+**************************************/
+/* stat, its st_mtim, and fork are POSIX, not ANSI. */
+#ifdef VVTBI_POSIX
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <ctype.h>
+#include <time.h>
+
+#ifdef VVTBI_POSIX
+#include <signal.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#endif
+
+#include "config.h"
+#include "io.h"
+#include "tokenizer.h"
+#include "program.h"
+#include "sample.h"
+#include "stats.h"
+
+int program_wide     = 0;
+int program_parallel = 1;
+
+/* The size and time of change of a file, to tell if it changed. */
+struct file_status {
+  long   mtime, mtime_nsec;
+  size_t size;
+};
+
+/* A cached program, and when it was last used. */
+struct cache_entry {
+  struct program *program;
+  unsigned long   used;
+};
+
+/* The compiled-program cache, least-recently-used goes first. */
+static struct cache_entry cache[VVTBI_PROGRAM_CACHE];
+
+/* The cache's clock, ticked on every lookup. */
+static unsigned long uses = 0;
+
+/* The size of a source chunk's arrays, as its worker sends
+   them, to be stitched into the program. */
+struct chunk {
+  size_t count;
+  size_t lines_count;
+  size_t strings_size;
+  size_t variable_count;
+  size_t function_count;
+  size_t constants_count;
+};
+
+/* The int values a variable, or an expression, may hold: low to
+   high. Empty, low above high, where nothing is known yet. */
+struct range {
+  long low;
+  long high;
+};
+
+/* What an int may hold. */
+static const struct range any = {INT_MIN, INT_MAX};
+
+/* What the range analysis flows along: the ranges of each
+   variable on entering each line and the lines reached so far,
+   read from states and grown into into, the ranges of each FOR
+   line's limit and step, the FOR and GOSUB lines, and the
+   program's numbers, in order, for a growing bound to go to. */
+struct flow {
+  struct range *states, *into;
+  char         *reached, *arrived;
+  struct range *limits, *steps;
+  size_t       *fors, for_count;
+  size_t       *gosubs, gosub_count;
+  long         *bounds;
+  size_t        bound_count;
+  int           widen;
+};
+
+/* The files being compiled for their INCLUDEs, outermost first. */
+static const char *including[VVTBI_INCLUDE_DEPTH];
+static int         include_depth = 0;
+
+static int type_expression (struct program *p, size_t *i, int mark);
+static struct range range_expression (struct program *p, size_t *i,
+  const struct range *state, int mark);
+
+/******************************************************************************/
+
+/**
+ * allocate
+ *
+ * @param pointer Memory to resize, or NULL.
+ * @param size The new size.
+ * @return pointer The [re]allocated memory.
+ */
+
+static void *allocate (void *pointer, size_t size)
+{
+  stats.allocations++;
+  pointer = realloc(pointer, size);
+  if (!pointer)
+  {
+    fprintf(stderr,
+      "*program.c: out of memory!\n");
+    exit(EXIT_FAILURE);
+  }
+  return pointer;
+}
+
+/**
+ * program_hash
+ *
+ * @param source The source code.
+ * @param n The length of the source code.
+ * @return hash The 32-bit FNV-1a hash of the source code.
+ */
+
+unsigned long program_hash (const char *source, size_t n)
+{
+  unsigned long hash;
+  size_t        i;
+  hash = 2166136261UL;
+  for (i = 0; i < n; i++)
+  {
+    hash ^= (unsigned char) source[i];
+    hash  = (hash * 16777619UL) & 0xffffffffUL;
+  }
+  return hash;
+}
+
+/**
+ * add_string
+ *
+ * @param p The program.
+ * @param string The string literal.
+ * @return offset The string's offset in the string pool.
+ */
+
+static int add_string (struct program *p, const char *string)
+{
+  size_t n, offset;
+  n      = strlen(string) + 1;
+  offset = p->strings_size;
+  p->strings = allocate(p->strings, offset + n);
+  memcpy(p->strings + offset, string, n);
+  p->strings_size += n;
+  return (int) offset;
+}
+
+/**
+ * add_constant
+ *
+ * @param p The program.
+ * @param number A wide or decimal number.
+ * @return The number's index in the constants.
+ */
+
+static int add_constant (struct program *p, long number)
+{
+  p->constants = allocate(p->constants,
+    (p->constants_count + 1) * sizeof *p->constants);
+  p->constants[p->constants_count] = number;
+  return (int) p->constants_count++;
+}
+
+/**
+ * clear_slots
+ *
+ * @param p The program.
+ * @return void
+ */
+
+static void clear_slots (struct program *p)
+{
+  size_t i;
+  for (i = 0; i < p->slots_size; i++)
+    p->slots[i] = -1;
+}
+
+/**
+ * find_slot
+ *
+ * @param p The program.
+ * @param name A variable's name.
+ * @return The place of the name in the slots table, or of the
+ *         empty slot it belongs in.
+ */
+
+static size_t find_slot (const struct program *p, const char *name)
+{
+  size_t i, mask;
+  mask = p->slots_size - 1;
+  for (i = program_hash(name, strlen(name)) & mask;
+  p->slots[i] >= 0 && strcmp(p->strings + p->names[p->slots[i]], name);
+  i = (i + 1) & mask)
+    ;
+  return i;
+}
+
+/**
+ * intern
+ *
+ * @param p The program.
+ * @param name A variable's name.
+ * @return The variable's slot, numbered anew if unseen.
+ */
+
+static int intern (struct program *p, const char *name)
+{
+  size_t i, size;
+  i = find_slot(p, name);
+  if (p->slots[i] >= 0)
+    return p->slots[i];
+  /* Keep the table at most half full, names and types as
+     large as the half. */
+  if (2 * (p->variable_count + 1) > p->slots_size)
+  {
+    free(p->slots);
+    p->slots_size *= 2;
+    p->slots       = allocate(NULL, p->slots_size * sizeof *p->slots);
+    p->names       = allocate(p->names,
+      p->slots_size / 2 * sizeof *p->names);
+    p->types       = allocate(p->types, p->slots_size / 2);
+    clear_slots(p);
+    for (size = 0; size < p->variable_count; size++)
+      p->slots[find_slot(p, p->strings + p->names[size])] = (int) size;
+    i = find_slot(p, name);
+  }
+  p->names[p->variable_count] = add_string(p, name);
+  p->types[p->variable_count] = (char) (program_wide ? PROGRAM_WIDE :
+    PROGRAM_INTEGER);
+  p->slots[i] = (int) p->variable_count;
+  return (int) p->variable_count++;
+}
+
+/**
+ * add_function
+ *
+ * @param p The program.
+ * @param name A host function's name, after CALL.
+ * @return The function's number, numbered anew if unseen.
+ */
+
+static int add_function (struct program *p, const char *name)
+{
+  size_t i;
+  /* Few functions are called, and only looked up at load. */
+  for (i = 0; i < p->function_count; i++)
+    if (!strcmp(p->strings + p->functions[i], name))
+      return (int) i;
+  p->functions = allocate(p->functions,
+    (p->function_count + 1) * sizeof *p->functions);
+  p->functions[p->function_count] = add_string(p, name);
+  return (int) p->function_count++;
+}
+
+/**
+ * compare_lines
+ *
+ * @param a A line.
+ * @param b A line.
+ * @return Their order by number, then by place.
+ */
+
+static int compare_lines (const void *a, const void *b)
+{
+  const int *x, *y;
+  x = a;
+  y = b;
+  if (x[0] != y[0])
+    return (x[0] > y[0]) - (x[0] < y[0]);
+  return (x[1] > y[1]) - (x[1] < y[1]);
+}
+
+/**
+ * eytzinger
+ *
+ * @param p The program.
+ * @param sorted Pairs of number and line, in order.
+ * @param i The next pair to place.
+ * @param k The place in the tree, from 1.
+ * @return i The next pair to place after the subtree at k.
+ */
+
+static size_t eytzinger (struct program *p, const int *sorted,
+  size_t i, size_t k)
+{
+  /* In order: the left subtree, k, then the right. */
+  if (k <= p->index_size)
+  {
+    i = eytzinger(p, sorted, i, 2 * k);
+    p->keys[k]  = sorted[2 * i];
+    p->index[k] = sorted[2 * i + 1];
+    i = eytzinger(p, sorted, i + 1, 2 * k + 1);
+  }
+  return i;
+}
+
+/**
+ * index_lines
+ *
+ * @param p The program.
+ * @return void
+ */
+
+static void index_lines (struct program *p)
+{
+  int   *sorted;
+  size_t i, n;
+  long   low, high;
+
+  free(p->index);
+  free(p->keys);
+  p->index      = NULL;
+  p->keys       = NULL;
+  p->index_size = 0;
+  p->base       = 0;
+  if (!p->lines_count)
+    return;
+  for (i = 0, low = high = p->lines[0].number; i < p->lines_count; i++)
+  {
+    if (p->lines[i].number < low)
+      low = p->lines[i].number;
+    if (p->lines[i].number > high)
+      high = p->lines[i].number;
+  }
+  /* Compact: a slot per number, holding its first line. */
+  if ((unsigned long) (high - low) <
+  (unsigned long) p->lines_count * VVTBI_LINE_SPAN)
+  {
+    p->base       = (int) low;
+    p->index_size = (size_t) (high - low + 1);
+    p->index      = allocate(NULL, p->index_size * sizeof *p->index);
+    for (i = 0; i < p->index_size; i++)
+      p->index[i] = -1;
+    for (i = p->lines_count; i-- > 0; )
+      p->index[p->lines[i].number - low] = (int) i;
+    return;
+  }
+  /* Sparse: the first line of each number, sorted... */
+  sorted = allocate(NULL, 2 * p->lines_count * sizeof *sorted);
+  for (i = 0; i < p->lines_count; i++)
+  {
+    sorted[2 * i]     = p->lines[i].number;
+    sorted[2 * i + 1] = (int) i;
+  }
+  qsort(sorted, p->lines_count, 2 * sizeof *sorted, compare_lines);
+  for (i = n = 0; i < p->lines_count; i++)
+    if (!n || sorted[2 * i] != sorted[2 * (n - 1)])
+    {
+      sorted[2 * n]     = sorted[2 * i];
+      sorted[2 * n + 1] = sorted[2 * i + 1];
+      n++;
+    }
+  /* ...then laid out breadth-first, so a search's first steps
+     share cache lines. */
+  p->index_size = n;
+  p->keys       = allocate(NULL, (n + 1) * sizeof *p->keys);
+  p->index      = allocate(NULL, (n + 1) * sizeof *p->index);
+  eytzinger(p, sorted, 0, 1);
+  free(sorted);
+}
+
+/**
+ * assigns
+ *
+ * @param p The program.
+ * @param line The index of a line in the line table.
+ * @param variable A variable's cell location.
+ * @return May the line's statement change the variable?
+ */
+
+static int assigns (const struct program *p, size_t line, int variable)
+{
+  const struct program_token *t;
+  int                         depth;
+  t = &p->tokens[p->lines[line].start + 1];
+  if (t->token == T_LET)
+    t++;
+  switch (t->token)
+  {
+    /* A subroutine may change anything. */
+    case T_GOSUB:
+      return 1;
+    case T_FOR:
+      return t[1].token == T_LETTER && t[1].value == variable;
+    case T_LETTER:
+      return t->value == variable && t[1].token == T_EQUAL;
+    /* INPUT and READ assign each variable listed; an array
+       element's index is passed over. */
+    case T_INPUT:
+    case T_READ:
+      for (t++; t->token == T_LETTER; t++)
+      {
+        if (t[1].token == T_LEFT_PAREN)
+          for (t += 2, depth = 1; depth && t->token != T_EOL &&
+          t->token != T_EOF; t++)
+            depth += (t->token == T_LEFT_PAREN) -
+              (t->token == T_RIGHT_PAREN);
+        else if ((t++)->value == variable)
+          return 1;
+        if (t->token != T_SEPERATOR)
+          break;
+      }
+      break;
+  }
+  return 0;
+}
+
+/**
+ * jumps_into
+ *
+ * @param p The program.
+ * @param from Destination of the first line jumping to each line.
+ * @param to Destination of the last line jumping to each line.
+ * @return void
+ */
+
+static void jumps_into (const struct program *p, long *from, long *to)
+{
+  const struct program_token *t;
+  size_t                      i;
+  long                        target;
+  for (i = 0; i < p->lines_count; i++)
+  {
+    from[i] = (long) p->lines_count;
+    to[i]   = -1;
+  }
+  for (i = 0; i < p->count; i++)
+  {
+    t = &p->tokens[i];
+    /* A jump's line number follows GOTO, GOSUB or THEN. */
+    if ((t->token != T_GOTO && t->token != T_GOSUB &&
+    t->token != T_THEN) || t[1].token != T_NUMBER || t->line < 0)
+      continue;
+    target = program_index(p, t[1].value);
+    if (target < 0)
+      continue;
+    if (t->line < from[target])
+      from[target] = t->line;
+    if (t->line > to[target])
+      to[target] = t->line;
+  }
+}
+
+/**
+ * prove_loop
+ *
+ * @param p The program.
+ * @param line The index of a FOR line in the line table.
+ * @param from The first line jumping to each line.
+ * @param to The last line jumping to each line.
+ * @return void
+ */
+
+static void prove_loop (struct program *p, size_t line, const long *from,
+  const long *to)
+{
+  const struct program_token *t;
+  struct program_array       *a;
+  struct program_token       *u;
+  size_t                      end, i;
+  long                        target;
+  int                         variable, low, high;
+
+  /* FOR v = number TO number [STEP ...]: whatever the step,
+     v stays within the numbers while in the body. */
+  t = &p->tokens[p->lines[line].start + 1];
+  if (t[0].token != T_FOR || t[1].token != T_LETTER ||
+  t[2].token != T_EQUAL || t[3].token != T_NUMBER ||
+  t[4].token != T_TO || t[5].token != T_NUMBER ||
+  (t[6].token != T_EOL && t[6].token != T_STEP))
+    return;
+  variable = t[1].value;
+  low      = t[3].value < t[5].value ? t[3].value : t[5].value;
+  high     = t[3].value < t[5].value ? t[5].value : t[3].value;
+  /* The body runs to its NEXT, entered only through the FOR,
+     and without v changed. */
+  for (end = line + 1; end < p->lines_count; end++)
+  {
+    t = &p->tokens[p->lines[end].start + 1];
+    if (t->token == T_NEXT)
+    {
+      if (t[1].token != T_LETTER)
+        return;
+      if (t[1].value == variable)
+        break;
+    }
+    if (assigns(p, end, variable))
+      return;
+  }
+  if (end == p->lines_count)
+    return;
+  for (i = line + 1; i <= end; i++)
+    if (from[i] <= (long) line || to[i] > (long) end)
+      return;
+  /* Nor left by a jump, or a RETURN, to where v may change
+     before a NEXT elsewhere goes back into the body. */
+  for (i = p->lines[line].start; i < p->lines[end].start; i++)
+  {
+    u = &p->tokens[i];
+    if (u->token == T_RETURN)
+      return;
+    if ((u->token != T_GOTO && u->token != T_GOSUB &&
+    u->token != T_THEN) || u[1].token != T_NUMBER)
+      continue;
+    target = program_index(p, u[1].value);
+    if (target >= 0 && (target < (long) line || target > (long) end))
+      return;
+  }
+  for (i = 0; i < p->lines_count; i++)
+  {
+    t = &p->tokens[p->lines[i].start + 1];
+    if ((i < line || i > end) && t->token == T_NEXT &&
+    (t[1].token != T_LETTER || t[1].value == variable))
+      return;
+  }
+  for (i = p->lines[line + 1].start; i < p->lines[end].start; i++)
+  {
+    u = &p->tokens[i];
+    if (u->token != T_LETTER || u[1].token != T_LEFT_PAREN ||
+    u[2].token != T_LETTER || u[2].value != variable ||
+    u[3].token != T_RIGHT_PAREN)
+      continue;
+    a = &p->arrays[u->value];
+    if (low >= 0 && (size_t) high < a->length)
+      u->flags |= PROGRAM_IN_BOUNDS;
+  }
+}
+
+/**
+ * layout_arrays
+ *
+ * @param p The program.
+ * @return void
+ */
+
+static void layout_arrays (struct program *p)
+{
+  struct program_token *t;
+  size_t                i, length, align;
+  long                 *from, *to;
+
+  free(p->arrays);
+  p->arrays = allocate(NULL,
+    (p->variable_count + 1) * sizeof *p->arrays);
+  for (i = 0; i < p->variable_count; i++)
+    p->arrays[i].length = 0;
+  /* DIM a(n) [, b(m) ...]; the largest DIM of an array wins. */
+  for (i = 0; i < p->lines_count; i++)
+    for (t = &p->tokens[p->lines[i].start + 1];
+    t->token == T_DIM || t->token == T_SEPERATOR; t += 5)
+    {
+      if (t[1].token != T_LETTER || t[2].token != T_LEFT_PAREN ||
+      t[3].token != T_NUMBER || t[4].token != T_RIGHT_PAREN)
+        break;
+      length = (size_t) t[3].value + 1;
+      if (length > p->arrays[t[1].value].length)
+        p->arrays[t[1].value].length = length;
+    }
+  /* One arena, each array on a cache line of its own. */
+  align         = VVTBI_ARENA_ALIGN / sizeof (int);
+  p->arena_size = 0;
+  for (i = 0; i < p->variable_count; i++)
+  {
+    p->arrays[i].base = p->arena_size;
+    p->arena_size    += (p->arrays[i].length + align - 1) / align * align;
+  }
+
+  /* Prove what indexes we can: numbers, and the variables
+     of counted loops. */
+  for (i = 0; i < p->count; i++)
+  {
+    t        = &p->tokens[i];
+    t->flags = 0;
+    if (t->token == T_LETTER && t[1].token == T_LEFT_PAREN &&
+    t[2].token == T_NUMBER && t[3].token == T_RIGHT_PAREN &&
+    (size_t) t[2].value < p->arrays[t->value].length)
+      t->flags |= PROGRAM_IN_BOUNDS;
+  }
+  if (!p->lines_count)
+    return;
+  from = allocate(NULL, p->lines_count * sizeof *from);
+  to   = allocate(NULL, p->lines_count * sizeof *to);
+  jumps_into(p, from, to);
+  for (i = 0; i < p->lines_count; i++)
+    prove_loop(p, i, from, to);
+  free(from);
+  free(to);
+}
+
+/**
+ * pack_data
+ *
+ * @param p The program.
+ * @return void
+ */
+
+static void pack_data (struct program *p)
+{
+  struct program_token *t;
+  size_t                i, n;
+
+  /* Every DATA item, in line order, for READ to take in turn
+     without a look at the tokens. */
+  for (i = 0, n = 0; i < p->count; i++)
+    n += p->tokens[i].token == T_NUMBER;
+  free(p->data);
+  p->data       = allocate(NULL, (n + 1) * sizeof *p->data);
+  p->data_count = 0;
+  p->data_error = -1;
+  for (i = 0; i < p->lines_count; i++)
+  {
+    t = &p->tokens[p->lines[i].start + 1];
+    if (t->token != T_DATA)
+      continue;
+    for (t++;; t++)
+    {
+      if (t->token == T_MINUS && t[1].token == T_NUMBER)
+      {
+        t++;
+        p->data[p->data_count++] = -t->value;
+      }
+      else if (t->token == T_NUMBER)
+        p->data[p->data_count++] = t->value;
+      /* Not an int, or none: note the first, for the
+         load to report, and skip to the next item. */
+      else
+      {
+        if (p->data_error < 0)
+          p->data_error = p->lines[i].number;
+        if (t->token == T_EOL || t->token == T_EOF)
+          break;
+        while (t[1].token != T_SEPERATOR && t[1].token != T_EOL &&
+        t[1].token != T_EOF)
+          t++;
+      }
+      if (t[1].token != T_SEPERATOR)
+        break;
+      t++;
+    }
+  }
+}
+
+/**
+ * type_factor
+ *
+ * @param p The program.
+ * @param i The index of the factor's first token, advanced past it.
+ * @param mark Flag the indexes to run on typed values?
+ * @return The factor's type.
+ */
+
+static int type_factor (struct program *p, size_t *i, int mark)
+{
+  size_t start;
+  int    type;
+  switch (p->tokens[*i].token)
+  {
+    case T_WIDE:
+      ++*i;
+      return PROGRAM_WIDE;
+    case T_DECIMAL:
+      ++*i;
+      return PROGRAM_DECIMAL;
+    case T_LEFT_PAREN:
+      ++*i;
+      type = type_expression(p, i, mark);
+      if (p->tokens[*i].token == T_RIGHT_PAREN)
+        ++*i;
+      return type;
+    case T_LETTER:
+      if (p->tokens[++*i].token != T_LEFT_PAREN)
+        return p->types[p->tokens[*i - 1].value];
+      /* Array elements are int, whatever their index. */
+      start = ++*i;
+      if (type_expression(p, i, mark) != PROGRAM_INTEGER && mark)
+        p->tokens[start].flags |= PROGRAM_TYPED;
+      if (p->tokens[*i].token == T_RIGHT_PAREN)
+        ++*i;
+      return PROGRAM_INTEGER;
+    /* CALL f(e, ...) gives an int, whatever its arguments. */
+    case T_CALL:
+      if (p->tokens[++*i].token != T_FUNCTION ||
+      p->tokens[++*i].token != T_LEFT_PAREN)
+        return PROGRAM_INTEGER;
+      do {
+        start = ++*i;
+        if (p->tokens[start].token == T_RIGHT_PAREN)
+          break;
+        if (type_expression(p, i, mark) != PROGRAM_INTEGER && mark)
+          p->tokens[start].flags |= PROGRAM_TYPED;
+      } while (p->tokens[*i].token == T_SEPERATOR);
+      if (p->tokens[*i].token == T_RIGHT_PAREN)
+        ++*i;
+      return PROGRAM_INTEGER;
+    case T_NUMBER:
+      ++*i;
+      break;
+  }
+  return PROGRAM_INTEGER;
+}
+
+/**
+ * type_expression
+ *
+ * @param p The program.
+ * @param i The index of the expression's first token, advanced past it.
+ * @param mark Flag the indexes to run on typed values?
+ * @return The expression's type: the widest of its factors.
+ */
+
+static int type_expression (struct program *p, size_t *i, int mark)
+{
+  int type, next;
+  for (type = type_factor(p, i, mark);
+  p->tokens[*i].token == T_PLUS || p->tokens[*i].token == T_MINUS ||
+  p->tokens[*i].token == T_ASTERISK || p->tokens[*i].token == T_SLASH;
+  type = next > type ? next : type)
+  {
+    ++*i;
+    next = type_factor(p, i, mark);
+  }
+  return type;
+}
+
+/**
+ * type_relation
+ *
+ * @param p The program.
+ * @param i The index of the relation's first token, advanced past it.
+ * @param mark Flag the indexes to run on typed values?
+ * @return The widest type of its expressions.
+ */
+
+static int type_relation (struct program *p, size_t *i, int mark)
+{
+  int type, next;
+  for (type = type_expression(p, i, mark);
+  p->tokens[*i].token >= T_EQUAL && p->tokens[*i].token <= T_NOT_EQUAL;
+  type = next > type ? next : type)
+  {
+    ++*i;
+    next = type_expression(p, i, mark);
+  }
+  return type;
+}
+
+/**
+ * type_line
+ *
+ * @param p The program.
+ * @param line The index of a line in the line table.
+ * @param mark Flag what must run on typed values?
+ * @return Did a variable's type widen?
+ */
+
+static int type_line (struct program *p, size_t line, int mark)
+{
+  struct program_token *t;
+  size_t                i, start;
+  int                   type, next, widened;
+
+  i = p->lines[line].start + 1;
+  if (p->tokens[i].token == T_LET)
+    i++;
+  t       = &p->tokens[i];
+  widened = 0;
+  switch (t->token)
+  {
+    /* v = e, or a(e) = e. */
+    case T_LETTER:
+      type = type_factor(p, &i, mark);
+      if (p->tokens[i].token != T_EQUAL)
+        break;
+      i++;
+      type = type_expression(p, &i, mark);
+      if (t[1].token == T_LEFT_PAREN)
+      {
+        if (mark && type != PROGRAM_INTEGER)
+          t->flags |= PROGRAM_TYPED;
+        break;
+      }
+      widened = type > p->types[t->value];
+      if (widened)
+        p->types[t->value] = (char) type;
+      if (mark && p->types[t->value] != PROGRAM_INTEGER)
+        t->flags |= PROGRAM_TYPED;
+      break;
+    /* FOR v = e TO e [STEP e]: v holds all three. */
+    case T_FOR:
+      if (t[1].token != T_LETTER || t[2].token != T_EQUAL)
+        break;
+      for (i += 3, type = PROGRAM_INTEGER;; i++)
+      {
+        next = type_expression(p, &i, mark);
+        type = next > type ? next : type;
+        if (p->tokens[i].token != T_TO && p->tokens[i].token != T_STEP)
+          break;
+      }
+      widened = type > p->types[t[1].value];
+      if (widened)
+        p->types[t[1].value] = (char) type;
+      if (mark && p->types[t[1].value] != PROGRAM_INTEGER)
+        t->flags |= PROGRAM_TYPED;
+      break;
+    case T_CALL:
+      type_factor(p, &i, mark);
+      break;
+    /* INPUT and READ v [, v ...] give ints, as the variables'
+       types; only array indexes need typing. */
+    case T_INPUT:
+    case T_READ:
+      do {
+        i++;
+        type_factor(p, &i, mark);
+      } while (p->tokens[i].token == T_SEPERATOR);
+      break;
+    case T_IF:
+      i++;
+      if (type_relation(p, &i, mark) != PROGRAM_INTEGER && mark)
+        t->flags |= PROGRAM_TYPED;
+      break;
+    case T_PRINT:
+      for (i++;; )
+        switch (p->tokens[i].token)
+        {
+          case T_STRING:
+          case T_SEPERATOR:
+            i++;
+            break;
+          case T_LETTER:
+          case T_NUMBER:
+          case T_WIDE:
+          case T_DECIMAL:
+          case T_LEFT_PAREN:
+          case T_CALL:
+            start = i;
+            if (type_expression(p, &i, mark) != PROGRAM_INTEGER && mark)
+              p->tokens[start].flags |= PROGRAM_TYPED;
+            break;
+          default:
+            return 0;
+        }
+  }
+  return widened;
+}
+
+/**
+ * infer_types
+ *
+ * @param p The program.
+ * @return void
+ */
+
+static void infer_types (struct program *p)
+{
+  size_t i;
+  int    widened;
+
+  /* A variable is as wide as anything assigned to it; widen
+     until nothing does, then flag what is not int. Types
+     never narrow, even when an edit removes a line. */
+  do {
+    for (i = 0, widened = 0; i < p->lines_count; i++)
+      widened |= type_line(p, i, 0);
+  } while (widened);
+  for (i = 0; i < p->lines_count; i++)
+    type_line(p, i, 1);
+}
+
+/**
+ * hull
+ *
+ * @param a A range.
+ * @param b A range.
+ * @return The least range holding both.
+ */
+
+static struct range hull (struct range a, struct range b)
+{
+  if (a.low > a.high)
+    return b;
+  if (b.low > b.high)
+    return a;
+  a.low  = b.low < a.low ? b.low : a.low;
+  a.high = b.high > a.high ? b.high : a.high;
+  return a;
+}
+
+/**
+ * arithmetic
+ *
+ * @param a A range.
+ * @param op T_PLUS, T_MINUS, T_ASTERISK or T_SLASH.
+ * @param b A range.
+ * @return The range of a op b: any int, if it may overflow.
+ */
+
+static struct range arithmetic (struct range a, int op, struct range b)
+{
+  struct range r, part;
+  double       corner[4];
+  int          i;
+
+  if (a.low > a.high || b.low > b.high)
+    return any;
+  /* x / 0 gives 0; otherwise divide by either side of 0, where
+     the quotient is monotonic, and INT_MIN / -1 overflows. */
+  if (op == T_SLASH)
+  {
+    r.low  = 1;
+    r.high = 0;
+    if (b.low <= 0 && b.high >= 0)
+    {
+      r.low = r.high = 0;
+      if (b.low < 0)
+      {
+        part.low  = b.low;
+        part.high = -1;
+        r = hull(r, arithmetic(a, T_SLASH, part));
+      }
+      if (b.high > 0)
+      {
+        part.low  = 1;
+        part.high = b.high;
+        r = hull(r, arithmetic(a, T_SLASH, part));
+      }
+      return r;
+    }
+    if (a.low == INT_MIN && b.high == -1)
+      return any;
+  }
+  /* Corners in double, to tell overflow without overflowing. */
+  for (i = 0; i < 4; i++)
+  {
+    r.low  = i & 1 ? a.high : a.low;
+    r.high = i & 2 ? b.high : b.low;
+    switch (op)
+    {
+      case T_PLUS:
+        corner[i] = (double) r.low + r.high;
+        break;
+      case T_MINUS:
+        corner[i] = (double) r.low - r.high;
+        break;
+      case T_ASTERISK:
+        corner[i] = (double) r.low * r.high;
+        break;
+      default:
+        corner[i] = (double) (r.low / r.high);
+        break;
+    }
+  }
+  r.low = r.high = 0;
+  for (i = 0; i < 4; i++)
+  {
+    if (corner[i] < INT_MIN || corner[i] > INT_MAX)
+      return any;
+    if (!i || corner[i] < r.low)
+      r.low = (long) corner[i];
+    if (!i || corner[i] > r.high)
+      r.high = (long) corner[i];
+  }
+  return r;
+}
+
+/**
+ * range_factor
+ *
+ * @param p The program.
+ * @param i The index of the factor's first token, advanced past it.
+ * @param state The range of each variable.
+ * @param mark Flag the divisions proven not to divide by zero?
+ * @return The factor's range.
+ */
+
+static struct range range_factor (struct program *p, size_t *i,
+  const struct range *state, int mark)
+{
+  struct range r;
+  switch (p->tokens[*i].token)
+  {
+    case T_NUMBER:
+      r.low = r.high = p->tokens[(*i)++].value;
+      return r;
+    case T_LEFT_PAREN:
+      ++*i;
+      r = range_expression(p, i, state, mark);
+      if (p->tokens[*i].token == T_RIGHT_PAREN)
+        ++*i;
+      return r;
+    case T_LETTER:
+      r = p->types[p->tokens[*i].value] == PROGRAM_INTEGER ?
+        state[p->tokens[*i].value] : any;
+      if (p->tokens[++*i].token != T_LEFT_PAREN)
+        return r;
+      /* Array elements may hold anything. */
+      ++*i;
+      range_expression(p, i, state, mark);
+      if (p->tokens[*i].token == T_RIGHT_PAREN)
+        ++*i;
+      return any;
+    /* As may what a host function gives. */
+    case T_CALL:
+      if (p->tokens[++*i].token != T_FUNCTION ||
+      p->tokens[++*i].token != T_LEFT_PAREN)
+        return any;
+      do {
+        if (p->tokens[++*i].token == T_RIGHT_PAREN)
+          break;
+        range_expression(p, i, state, mark);
+      } while (p->tokens[*i].token == T_SEPERATOR);
+      if (p->tokens[*i].token == T_RIGHT_PAREN)
+        ++*i;
+      return any;
+    case T_WIDE:
+    case T_DECIMAL:
+      ++*i;
+      break;
+  }
+  return any;
+}
+
+/**
+ * range_term
+ *
+ * @param p The program.
+ * @param i The index of the term's first token, advanced past it.
+ * @param state The range of each variable.
+ * @param mark Flag the divisions proven not to divide by zero?
+ * @return The term's range.
+ */
+
+static struct range range_term (struct program *p, size_t *i,
+  const struct range *state, int mark)
+{
+  struct program_token *op;
+  struct range          r, next;
+  for (r = range_factor(p, i, state, mark);
+  p->tokens[*i].token == T_ASTERISK || p->tokens[*i].token == T_SLASH;
+  r = arithmetic(r, op->token, next))
+  {
+    op   = &p->tokens[(*i)++];
+    next = range_factor(p, i, state, mark);
+    if (mark && op->token == T_SLASH &&
+    (next.low > 0 || next.high < 0))
+      op->flags |= PROGRAM_NONZERO;
+  }
+  return r;
+}
+
+/**
+ * range_expression
+ *
+ * @param p The program.
+ * @param i The index of the expression's first token, advanced past it.
+ * @param state The range of each variable.
+ * @param mark Flag the divisions proven not to divide by zero?
+ * @return The expression's range.
+ */
+
+static struct range range_expression (struct program *p, size_t *i,
+  const struct range *state, int mark)
+{
+  struct range r, next;
+  int          op;
+  for (r = range_term(p, i, state, mark);
+  p->tokens[*i].token == T_PLUS || p->tokens[*i].token == T_MINUS;
+  r = arithmetic(r, op, next))
+  {
+    op   = p->tokens[(*i)++].token;
+    next = range_term(p, i, state, mark);
+  }
+  return r;
+}
+
+/**
+ * compare_bounds
+ *
+ * @param a A number.
+ * @param b A number.
+ * @return Their order.
+ */
+
+static int compare_bounds (const void *a, const void *b)
+{
+  const long *x, *y;
+  x = a;
+  y = b;
+  return (*x > *y) - (*x < *y);
+}
+
+/**
+ * bound
+ *
+ * @param f The analysis.
+ * @param from A bound growing.
+ * @param to What it grows to.
+ * @return The bound to grow it to: to, unless widening, then
+ *         the nearest of the program's numbers past to, or the
+ *         end.
+ */
+
+static long bound (const struct flow *f, long from, long to)
+{
+  size_t low, high, middle;
+  if (!f->widen || to == from)
+    return to;
+  for (low = 0, high = f->bound_count; low < high; )
+  {
+    middle = low + (high - low) / 2;
+    if (f->bounds[middle] < to)
+      low = middle + 1;
+    else
+      high = middle;
+  }
+  if (to > from)
+    return low < f->bound_count ? f->bounds[low] : INT_MAX;
+  if (low < f->bound_count && f->bounds[low] == to)
+    return to;
+  return low ? f->bounds[low - 1] : INT_MIN;
+}
+
+/**
+ * flow_into
+ *
+ * @param p The program.
+ * @param f The analysis.
+ * @param line The index of a line in the line table, or past it.
+ * @param state The ranges on entering the line, by one way in.
+ * @return Did the line's ranges grow?
+ */
+
+static int flow_into (const struct program *p, struct flow *f,
+  size_t line, const struct range *state)
+{
+  struct range *in;
+  size_t        v;
+  int           grew;
+  if (line >= p->lines_count)
+    return 0;
+  in = &f->into[line * p->variable_count];
+  if (!f->arrived[line])
+  {
+    f->arrived[line] = 1;
+    memcpy(in, state, p->variable_count * sizeof *in);
+    return 1;
+  }
+  /* Past a few rounds, a bound still growing goes further. */
+  for (v = 0, grew = 0; v < p->variable_count; v++)
+  {
+    if (state[v].low < in[v].low)
+    {
+      in[v].low = bound(f, in[v].low, state[v].low);
+      grew      = 1;
+    }
+    if (state[v].high > in[v].high)
+    {
+      in[v].high = bound(f, in[v].high, state[v].high);
+      grew       = 1;
+    }
+  }
+  return grew;
+}
+
+/**
+ * widen
+ *
+ * @param f The analysis.
+ * @param r A range, empty at first, to grow.
+ * @param next A range it must hold.
+ * @return Did it grow?
+ */
+
+static int widen (const struct flow *f, struct range *r, struct range next)
+{
+  next = hull(*r, next);
+  if (r->low <= r->high)
+  {
+    next.low  = bound(f, r->low, next.low);
+    next.high = bound(f, r->high, next.high);
+  }
+  if (next.low == r->low && next.high == r->high)
+    return 0;
+  *r = next;
+  return 1;
+}
+
+/**
+ * refine
+ *
+ * @param p The program.
+ * @param t The relation of an IF: v op number, say.
+ * @param taken Destination of the ranges if the IF jumps.
+ * @param fallen Destination of the ranges if not.
+ * @return void
+ */
+
+static void refine (const struct program *p, const struct program_token *t,
+  struct range *taken, struct range *fallen)
+{
+  struct range *yes, *no;
+  long          n;
+  if (t[0].token != T_LETTER || t[1].token < T_EQUAL ||
+  t[1].token > T_NOT_EQUAL || t[2].token != T_NUMBER ||
+  t[3].token != T_THEN || p->types[t[0].value] != PROGRAM_INTEGER)
+    return;
+  yes = &taken[t[0].value];
+  no  = &fallen[t[0].value];
+  n   = t[2].value;
+  /* <> is = with the ways swapped, >= is <, and <= is >. */
+  if (t[1].token == T_NOT_EQUAL || t[1].token == T_GT_EQ ||
+  t[1].token == T_LT_EQ)
+  {
+    yes = &fallen[t[0].value];
+    no  = &taken[t[0].value];
+  }
+  switch (t[1].token)
+  {
+    case T_EQUAL:
+    case T_NOT_EQUAL:
+      yes->low  = n > yes->low ? n : yes->low;
+      yes->high = n < yes->high ? n : yes->high;
+      if (no->low == n)
+        no->low++;
+      else if (no->high == n)
+        no->high--;
+      break;
+    case T_LT:
+    case T_GT_EQ:
+      yes->high = n - 1 < yes->high ? n - 1 : yes->high;
+      no->low   = n > no->low ? n : no->low;
+      break;
+    case T_GT:
+    case T_LT_EQ:
+      yes->low  = n + 1 > yes->low ? n + 1 : yes->low;
+      no->high  = n < no->high ? n : no->high;
+      break;
+  }
+}
+
+/**
+ * range_line
+ *
+ * @param p The program.
+ * @param f The analysis.
+ * @param line The index of a reached line in the line table.
+ * @param out Room for the ranges after it, twice.
+ * @param mark Flag the divisions proven not to divide by zero?
+ * @return Did the ranges of a line it leads to grow?
+ */
+
+static int range_line (struct program *p, struct flow *f, size_t line,
+  struct range *out, int mark)
+{
+  struct program_token *t;
+  struct range         *in, *other, r, past;
+  size_t                i, k, n, end;
+  long                  target;
+  int                   grew, called, v;
+
+  n     = p->variable_count;
+  in    = &f->states[line * n];
+  other = out + n;
+  /* Nothing is known once a host function is called. */
+  end = line + 1 < p->lines_count ? p->lines[line + 1].start : p->count;
+  for (i = p->lines[line].start, called = 0; i < end && !called; i++)
+    called = p->tokens[i].token == T_CALL;
+  if (called)
+    for (in = other + n, k = 0; k < n; k++)
+      in[k] = any;
+  memcpy(out, in, n * sizeof *out);
+  i = p->lines[line].start + 1;
+  if (p->tokens[i].token == T_LET)
+    i++;
+  t    = &p->tokens[i];
+  grew = 0;
+  switch (t->token)
+  {
+    /* v = e, or a(e) = e. */
+    case T_LETTER:
+      range_factor(p, &i, in, mark);
+      if (p->tokens[i].token != T_EQUAL)
+        break;
+      i++;
+      r = range_expression(p, &i, in, mark);
+      if (t[1].token != T_LEFT_PAREN &&
+      p->types[t->value] == PROGRAM_INTEGER)
+        out[t->value] = r;
+      break;
+    /* FOR v = e TO e [STEP e]: v is set before the limit is
+       evaluated; NEXT steps it, against the limit. */
+    case T_FOR:
+      if (t[1].token != T_LETTER || t[2].token != T_EQUAL)
+        break;
+      i += 3;
+      v = t[1].value;
+      r = range_expression(p, &i, in, mark);
+      if (p->types[v] == PROGRAM_INTEGER && !called)
+        out[v] = r;
+      r.low = r.high = 1;
+      if (p->tokens[i].token == T_TO)
+      {
+        i++;
+        grew |= widen(f, &f->limits[line],
+          range_expression(p, &i, out, mark));
+      }
+      if (p->tokens[i].token == T_STEP)
+      {
+        i++;
+        r = range_expression(p, &i, out, mark);
+      }
+      grew |= widen(f, &f->steps[line], r);
+      break;
+    /* NEXT [v] steps the variable of a FOR of v, or of any, and
+       goes back to its body while within the limit; or on. */
+    case T_NEXT:
+      v         = t[1].token == T_LETTER ? t[1].value : -1;
+      past.low  = 1;
+      past.high = 0;
+      for (k = 0; k < f->for_count; k++)
+      {
+        t = &p->tokens[p->lines[f->fors[k]].start + 1];
+        if ((v >= 0 && t[1].value != v) ||
+        p->types[t[1].value] != PROGRAM_INTEGER)
+          continue;
+        memcpy(other, out, n * sizeof *other);
+        r    = arithmetic(out[t[1].value], T_PLUS, f->steps[f->fors[k]]);
+        past = hull(past, r);
+        /* Back only while the step keeps within the limit. */
+        if (f->steps[f->fors[k]].low > 0 &&
+        f->limits[f->fors[k]].high < r.high)
+          r.high = f->limits[f->fors[k]].high;
+        if (f->steps[f->fors[k]].high < 0 &&
+        f->limits[f->fors[k]].low > r.low)
+          r.low = f->limits[f->fors[k]].low;
+        other[t[1].value] = r;
+        if (r.low <= r.high)
+          grew |= flow_into(p, f, f->fors[k] + 1, other);
+      }
+      /* Which loop an unnamed NEXT steps is not known. */
+      for (k = 0; v < 0 && k < f->for_count; k++)
+        out[p->tokens[p->lines[f->fors[k]].start + 2].value] = any;
+      if (v >= 0 && p->types[v] == PROGRAM_INTEGER)
+      {
+        /* NEXT without FOR stops the program. */
+        if (past.low > past.high)
+          return grew;
+        out[v] = past;
+      }
+      break;
+    case T_GOTO:
+    case T_GOSUB:
+      target = t[1].token == T_NUMBER ? program_index(p, t[1].value) : -1;
+      /* A jump to no line goes on, warned. */
+      if (target >= 0)
+        return flow_into(p, f, (size_t) target, out);
+      break;
+    case T_RETURN:
+      for (k = 0; k < f->gosub_count; k++)
+        grew |= flow_into(p, f, f->gosubs[k] + 1, out);
+      return grew;
+    case T_IF:
+      i++;
+      memcpy(other, out, n * sizeof *other);
+      refine(p, &p->tokens[i], other, out);
+      range_expression(p, &i, in, mark);
+      while (p->tokens[i].token >= T_EQUAL &&
+      p->tokens[i].token <= T_NOT_EQUAL)
+      {
+        i++;
+        range_expression(p, &i, in, mark);
+      }
+      target = p->tokens[i].token == T_THEN &&
+        p->tokens[i + 1].token == T_NUMBER ?
+        program_index(p, p->tokens[i + 1].value) : -1;
+      for (v = 0; (size_t) v < n; v++)
+        if (other[v].low > other[v].high)
+          break;
+      /* A way the relation rules out is not taken; a jump to no
+         line goes on, warned. */
+      if ((size_t) v == n)
+        grew |= flow_into(p, f, target >= 0 ? (size_t) target : line + 1,
+          other);
+      for (v = 0; (size_t) v < n; v++)
+        if (out[v].low > out[v].high)
+          return grew;
+      break;
+    case T_PRINT:
+      for (i++;; )
+        if (p->tokens[i].token == T_STRING ||
+        p->tokens[i].token == T_SEPERATOR)
+          i++;
+        else if (p->tokens[i].token == T_LETTER ||
+        p->tokens[i].token == T_NUMBER || p->tokens[i].token == T_WIDE ||
+        p->tokens[i].token == T_DECIMAL ||
+        p->tokens[i].token == T_LEFT_PAREN || p->tokens[i].token == T_CALL)
+          range_expression(p, &i, in, mark);
+        else
+          break;
+      break;
+    case T_CALL:
+      range_factor(p, &i, in, mark);
+      break;
+    /* Anything may be read into v. */
+    case T_INPUT:
+    case T_READ:
+      do {
+        t = &p->tokens[++i];
+        range_factor(p, &i, in, mark);
+        if (t->token == T_LETTER && t[1].token != T_LEFT_PAREN)
+          out[t->value] = any;
+      } while (p->tokens[i].token == T_SEPERATOR);
+      break;
+    /* A CHAIN leaves the program. */
+    case T_CHAIN:
+      return 0;
+    case T_REM:
+    case T_DIM:
+    case T_DATA:
+    case T_INCLUDE:
+      break;
+    /* Anything else may change anything. */
+    default:
+      for (k = 0; k < n; k++)
+        out[k] = any;
+      break;
+  }
+  return grew | flow_into(p, f, line + 1, out);
+}
+
+/**
+ * prove_divisions
+ *
+ * @param p The program, its types inferred.
+ * @return void
+ */
+
+static void prove_divisions (struct program *p)
+{
+  struct flow   f;
+  struct range *out, *states;
+  char         *reached;
+  size_t        i, n, round;
+  int           grew;
+
+  n = p->variable_count;
+  for (i = 0; i < p->count; i++)
+    p->tokens[i].flags &= ~PROGRAM_NONZERO;
+  if (!p->lines_count ||
+  (p->lines_count + 2) * (n + 1) > VVTBI_RANGE_CELLS)
+    return;
+  f.states      = allocate(NULL, p->lines_count * (n + 1) * sizeof *out);
+  f.reached     = allocate(NULL, p->lines_count);
+  f.limits      = allocate(NULL, p->lines_count * sizeof *f.limits);
+  f.steps       = allocate(NULL, p->lines_count * sizeof *f.steps);
+  f.fors        = allocate(NULL, p->lines_count * sizeof *f.fors);
+  f.gosubs      = allocate(NULL, p->lines_count * sizeof *f.gosubs);
+  f.bounds      = allocate(NULL, (p->count + 1) * sizeof *f.bounds);
+  out           = allocate(NULL, 3 * (n + 1) * sizeof *out);
+  f.for_count   = f.gosub_count = f.bound_count = 0;
+  f.widen       = 0;
+  memset(f.reached, 0, p->lines_count);
+  for (i = 0; i < p->lines_count; i++)
+  {
+    f.limits[i].low  = f.steps[i].low  = 1;
+    f.limits[i].high = f.steps[i].high = 0;
+    switch (p->tokens[p->lines[i].start + 1].token)
+    {
+      case T_FOR:
+        if (p->tokens[p->lines[i].start + 2].token == T_LETTER)
+          f.fors[f.for_count++] = i;
+        break;
+      case T_GOSUB:
+        f.gosubs[f.gosub_count++] = i;
+        break;
+    }
+  }
+  for (i = 0; i < p->count; i++)
+    if (p->tokens[i].token == T_NUMBER)
+      f.bounds[f.bound_count++] = p->tokens[i].value;
+  qsort(f.bounds, f.bound_count, sizeof *f.bounds, compare_bounds);
+
+  /* The program may begin with any values: the REPL's, or a
+     CHAIN's. Flow the ranges along the lines until none grows,
+     widening past VVTBI_RANGE_ROUNDS; narrow what widening lost,
+     by as many rounds from the ranges found, each flowed afresh;
+     then flag what is proven. */
+  for (i = 0; i < n; i++)
+    out[i] = any;
+  f.into    = f.states;
+  f.arrived = f.reached;
+  flow_into(p, &f, 0, out);
+  for (round = 0, grew = 1; grew; round++)
+  {
+    f.widen = round >= VVTBI_RANGE_ROUNDS;
+    for (i = 0, grew = 0; i < p->lines_count; i++)
+      if (f.reached[i])
+        grew |= range_line(p, &f, i, out, 0);
+  }
+  f.into    = allocate(NULL, p->lines_count * (n + 1) * sizeof *out);
+  f.arrived = allocate(NULL, p->lines_count);
+  for (f.widen = 0, round = 0; round < VVTBI_RANGE_ROUNDS; round++)
+  {
+    memset(f.arrived, 0, p->lines_count);
+    for (i = 0; i < n; i++)
+      out[i] = any;
+    flow_into(p, &f, 0, out);
+    for (i = 0; i < p->lines_count; i++)
+      if (f.reached[i])
+        range_line(p, &f, i, out, 0);
+    states    = f.states;
+    reached   = f.reached;
+    f.states  = f.into;
+    f.reached = f.arrived;
+    f.into    = states;
+    f.arrived = reached;
+  }
+  for (i = 0; i < p->lines_count; i++)
+    if (f.reached[i])
+      range_line(p, &f, i, out, 1);
+  free(f.states);
+  free(f.into);
+  free(f.reached);
+  free(f.arrived);
+  free(f.limits);
+  free(f.steps);
+  free(f.fors);
+  free(f.gosubs);
+  free(f.bounds);
+  free(out);
+}
+
+/**
+ * module_path
+ *
+ * @param p The program naming the module.
+ * @param name The module's file, relative to the program's.
+ * @return path The module's path, to be freed.
+ */
+
+static char *module_path (const struct program *p, const char *name)
+{
+  const char *slash;
+  char       *path;
+  size_t      n;
+  slash = strrchr(p->file, '/');
+  n     = name[0] == '/' || !slash ? 0 : (size_t) (slash - p->file + 1);
+  path  = allocate(NULL, n + strlen(name) + 1);
+  memcpy(path, p->file, n);
+  strcpy(path + n, name);
+  return path;
+}
+
+/**
+ * merge
+ *
+ * @param p The program.
+ * @param line The index of an INCLUDE line in the line table.
+ * @param m The module it includes.
+ * @return void
+ */
+
+static void merge (struct program *p, size_t line, const struct program *m)
+{
+  struct program_token *t;
+  size_t                at, lead, count, total, base, pool, i;
+
+  /* The module's tokens go after the INCLUDE line, each a line
+     of its own: new-lines are added if either lacks them. */
+  at    = line + 1 < p->lines_count ? p->lines[line + 1].start :
+    p->count - 1;
+  count = m->count - 1;
+  lead  = p->tokens[at - 1].token != T_EOL;
+  total = lead + count + (count && m->tokens[count - 1].token != T_EOL);
+  p->tokens = allocate(p->tokens, (p->count + total) * sizeof *p->tokens);
+  memmove(&p->tokens[at + total], &p->tokens[at],
+    (p->count - at) * sizeof *p->tokens);
+  p->count += total;
+  for (i = at + total; i < p->count; i++)
+    if (p->tokens[i].line >= 0)
+      p->tokens[i].line += (int) m->lines_count;
+
+  /* Its lines, after the INCLUDE line. */
+  p->lines = allocate(p->lines,
+    (p->lines_count + m->lines_count) * sizeof *p->lines);
+  memmove(&p->lines[line + 1 + m->lines_count], &p->lines[line + 1],
+    (p->lines_count - line - 1) * sizeof *p->lines);
+  p->lines_count += m->lines_count;
+  for (i = line + 1 + m->lines_count; i < p->lines_count; i++)
+    p->lines[i].start += total;
+  for (i = 0; i < m->lines_count; i++)
+  {
+    p->lines[line + 1 + i].number = m->lines[i].number;
+    p->lines[line + 1 + i].start  = at + lead + m->lines[i].start;
+    p->lines[line + 1 + i].target = -1;
+  }
+
+  /* Its tokens, strings and text, as program_edit splices a
+     line's. */
+  base = p->length;
+  pool = p->strings_size;
+  if (m->strings_size)
+  {
+    p->strings = allocate(p->strings, pool + m->strings_size);
+    memcpy(p->strings + pool, m->strings, m->strings_size);
+    p->strings_size += m->strings_size;
+  }
+  for (i = 0; i < total; i++)
+  {
+    t = &p->tokens[at + i];
+    if (i < lead || i - lead >= count)
+    {
+      t->token  = T_EOL;
+      t->value  = 0;
+      t->line   = -1;
+      t->offset = (long) (i < lead ? base : base + m->length);
+    }
+    else
+    {
+      *t = m->tokens[i - lead];
+      t->offset += base;
+      if (t->line >= 0)
+        t->line += (int) line + 1;
+      if (t->token == T_STRING)
+        t->value += (int) pool;
+      else if (t->token == T_LETTER)
+        t->value = intern(p, m->strings + m->names[t->value]);
+      else if (t->token == T_FUNCTION)
+        t->value = add_function(p, m->strings + m->functions[t->value]);
+      else if (t->token == T_WIDE || t->token == T_DECIMAL)
+        t->value = add_constant(p, m->constants[t->value]);
+    }
+    t->flags = 0;
+  }
+  p->source  = allocate(p->source, base + m->length + 1);
+  memcpy(p->source + base, m->source, m->length + 1);
+  p->length += m->length;
+  p->tokens[p->count - 1].offset = (long) p->length;
+}
+
+/**
+ * include_modules
+ *
+ * @param p The program, scanned.
+ * @return void
+ */
+
+static void include_modules (struct program *p)
+{
+  struct program_token *t;
+  struct program       *m;
+  char                 *path;
+  size_t                i;
+  int                   k;
+
+  for (i = 0; i < p->lines_count; i++)
+  {
+    t = &p->tokens[p->lines[i].start + 1];
+    if (t->token != T_INCLUDE || t[1].token != T_STRING)
+      continue;
+    path = module_path(p, p->strings + t[1].value);
+    for (k = 0; k < include_depth && strcmp(including[k], path); k++)
+      ;
+    if (k < include_depth || !strcmp(p->file, path))
+    {
+      fprintf(stderr,
+        "*program.c: `%s' includes itself!\n", path);
+      exit(EXIT_FAILURE);
+    }
+    if (include_depth == VVTBI_INCLUDE_DEPTH)
+    {
+      fprintf(stderr,
+        "*program.c: includes nest deeper than %d!\n",
+        VVTBI_INCLUDE_DEPTH);
+      exit(EXIT_FAILURE);
+    }
+    /* Compiled once, and cached: its own INCLUDEs are merged. */
+    including[include_depth++] = p->file;
+    m = program_load(path);
+    include_depth--;
+    free(path);
+    merge(p, i, m);
+    /* Skip its lines, and keep it, to tell if it is fresh. */
+    i += m->lines_count;
+    p->modules = allocate(p->modules,
+      (p->module_count + 1) * sizeof *p->modules);
+    p->modules[p->module_count++] = m;
+  }
+}
+
+/**
+ * create
+ *
+ * @param name The name of the source code.
+ * @param source The source code, which the program takes over, or
+ *               NULL.
+ * @param n The length of the source code.
+ * @return p An empty program, nothing scanned.
+ */
+
+static struct program *create (const char *name, char *source, size_t n)
+{
+  struct program *p;
+
+  p                  = allocate(NULL, sizeof *p);
+  p->file            = allocate(NULL, strlen(name) + 1);
+  strcpy(p->file, name);
+  p->source          = source;
+  p->length          = n;
+  p->size            = n;
+  p->mtime           = -1;
+  p->mtime_nsec      = 0;
+  p->hash            = source ? program_hash(source, n) : 0;
+  p->tokens          = NULL;
+  p->strings         = NULL;
+  p->strings_size    = 0;
+  p->count           = 0;
+  p->lines           = NULL;
+  p->lines_count     = 0;
+  p->index           = NULL;
+  p->keys            = NULL;
+  p->arrays          = NULL;
+  p->variable_count  = 0;
+  p->constants       = NULL;
+  p->constants_count = 0;
+  p->functions       = NULL;
+  p->function_count  = 0;
+  p->modules         = NULL;
+  p->module_count    = 0;
+  p->data            = NULL;
+  p->data_count      = 0;
+  p->slots_size      = 16;
+  p->slots           = allocate(NULL, p->slots_size * sizeof *p->slots);
+  p->names           = allocate(NULL,
+    p->slots_size / 2 * sizeof *p->names);
+  p->types           = allocate(NULL, p->slots_size / 2);
+  clear_slots(p);
+  p->refs            = 1;
+  return p;
+}
+
+/**
+ * scan
+ *
+ * @param p An empty program.
+ * @param text The source code to scan, from a line's start.
+ * @param n The length of text.
+ * @return void
+ */
+
+static void scan (struct program *p, const char *text, size_t n)
+{
+  struct program_token *t;
+  const char           *c, *end;
+  size_t                size, lines_size;
+  int                   line_start, line;
+
+  /* There is at most a line per new-line, so count them once
+     rather than grow the line table as we go. Most tokens span
+     a few characters; guess, then double. */
+  for (c = text, end = text + n, lines_size = 1; c < end; c++)
+  {
+    c = memchr(c, '\n', end - c);
+    if (!c)
+      break;
+    lines_size++;
+  }
+  size            = n / 4 + lines_size + 16;
+  p->tokens       = allocate(NULL, size * sizeof *p->tokens);
+  p->lines        = allocate(NULL, lines_size * sizeof *p->lines);
+
+  tokenizer_buffer(p->file, text, n);
+  line_start = 1;
+  line       = -1;
+  for (;;)
+  {
+    if (p->count == size)
+    {
+      size     *= 2;
+      p->tokens = allocate(p->tokens, size * sizeof *p->tokens);
+    }
+    t         = &p->tokens[p->count];
+    t->token  = tokenizer_token();
+    t->offset = tokenizer_offset();
+    /* Tokens after EOL belong to no line, until the next number. */
+    if (line_start)
+      line = -1;
+    switch (t->token)
+    {
+      case T_NUMBER:
+        t->value = tokenizer_num();
+        /* A number beginning a line is its line number. */
+        if (line_start)
+        {
+          if (p->lines_count == lines_size)
+          {
+            lines_size *= 2;
+            p->lines    = allocate(p->lines,
+              lines_size * sizeof *p->lines);
+          }
+          line = (int) p->lines_count;
+          p->lines[p->lines_count].number  = t->value;
+          p->lines[p->lines_count].target  = -1;
+          p->lines[p->lines_count++].start = p->count;
+        }
+        break;
+      case T_LETTER:
+        /* The name after CALL is a host function's. */
+        if (p->count && p->tokens[p->count - 1].token == T_CALL)
+        {
+          t->token = T_FUNCTION;
+          t->value = add_function(p, tokenizer_name());
+          break;
+        }
+        t->value = intern(p, tokenizer_name());
+        break;
+      case T_STRING:
+        t->value = add_string(p, tokenizer_string());
+        break;
+      case T_WIDE:
+      case T_DECIMAL:
+        t->value = add_constant(p, tokenizer_wide());
+        break;
+      default:
+        t->value = 0;
+        break;
+    }
+    t->line  = line;
+    t->flags = 0;
+    p->count++;
+    line_start = t->token == T_EOL;
+    /* The T_EOF token is kept, it ends the program. */
+    if (tokenizer_finished())
+      break;
+    tokenizer_next();
+  }
+}
+
+#ifdef VVTBI_POSIX
+
+/**
+ * stitch
+ *
+ * @param p The program scanned so far, to its last chunk's T_EOL.
+ * @param m The next chunk, scanned alone.
+ * @param base The offset of the chunk in the source code.
+ * @param last Is it the last chunk? Only its T_EOF is kept.
+ * @return void
+ */
+
+static void stitch (struct program *p, const struct program *m,
+  size_t base, int last)
+{
+  struct program_token *t;
+  int                  *letters, *functions;
+  size_t                i, count;
+
+  count     = last ? m->count : m->count - 1;
+  p->tokens = allocate(p->tokens, (p->count + count) * sizeof *p->tokens);
+  p->lines  = allocate(p->lines,
+    (p->lines_count + m->lines_count + 1) * sizeof *p->lines);
+  for (i = 0; i < m->lines_count; i++)
+  {
+    p->lines[p->lines_count + i].number = m->lines[i].number;
+    p->lines[p->lines_count + i].start  = p->count + m->lines[i].start;
+    p->lines[p->lines_count + i].target = -1;
+  }
+  /* The chunk's names and strings are added in the order they
+     are met, as if scanned with the rest: the program is the
+     same as the one scanned whole. */
+  letters   = allocate(NULL, (m->variable_count + 1) * sizeof *letters);
+  functions = allocate(NULL, (m->function_count + 1) * sizeof *functions);
+  for (i = 0; i < m->variable_count; i++)
+    letters[i] = -1;
+  for (i = 0; i < m->function_count; i++)
+    functions[i] = -1;
+  for (i = 0; i < count; i++)
+  {
+    t          = &p->tokens[p->count + i];
+    *t         = m->tokens[i];
+    t->offset += (long) base;
+    if (t->line >= 0)
+      t->line += (int) p->lines_count;
+    if (t->token == T_STRING)
+      t->value = add_string(p, m->strings + t->value);
+    else if (t->token == T_LETTER)
+    {
+      if (letters[t->value] < 0)
+        letters[t->value] = intern(p, m->strings + m->names[t->value]);
+      t->value = letters[t->value];
+    }
+    else if (t->token == T_FUNCTION)
+    {
+      if (functions[t->value] < 0)
+        functions[t->value] = add_function(p,
+          m->strings + m->functions[t->value]);
+      t->value = functions[t->value];
+    }
+    else if (t->token == T_WIDE || t->token == T_DECIMAL)
+      t->value = add_constant(p, m->constants[t->value]);
+  }
+  p->count       += count;
+  p->lines_count += m->lines_count;
+  free(letters);
+  free(functions);
+}
+
+/**
+ * send_chunk
+ *
+ * @param fd The pipe to the loader.
+ * @param m The chunk, scanned.
+ * @return Was the chunk sent whole?
+ */
+
+static int send_chunk (int fd, struct program *m)
+{
+  struct chunk c;
+  c.count           = m->count;
+  c.lines_count     = m->lines_count;
+  c.strings_size    = m->strings_size;
+  c.variable_count  = m->variable_count;
+  c.function_count  = m->function_count;
+  c.constants_count = m->constants_count;
+  return io_transfer(fd, &c, sizeof c, 1) &&
+    io_transfer(fd, m->tokens, c.count * sizeof *m->tokens, 1) &&
+    io_transfer(fd, m->lines, c.lines_count * sizeof *m->lines, 1) &&
+    io_transfer(fd, m->strings, c.strings_size, 1) &&
+    io_transfer(fd, m->names, c.variable_count * sizeof *m->names, 1) &&
+    io_transfer(fd, m->functions,
+      c.function_count * sizeof *m->functions, 1) &&
+    io_transfer(fd, m->constants,
+      c.constants_count * sizeof *m->constants, 1);
+}
+
+/**
+ * receive_chunk
+ *
+ * @param fd The pipe from a worker.
+ * @param m An empty program to receive the chunk into.
+ * @return Was the chunk received whole?
+ */
+
+static int receive_chunk (int fd, struct program *m)
+{
+  struct chunk c;
+  if (!io_transfer(fd, &c, sizeof c, 0))
+    return 0;
+  m->tokens    = allocate(m->tokens, (c.count + 1) * sizeof *m->tokens);
+  m->lines     = allocate(m->lines,
+    (c.lines_count + 1) * sizeof *m->lines);
+  m->strings   = allocate(m->strings, c.strings_size + 1);
+  m->names     = allocate(m->names,
+    (c.variable_count + 1) * sizeof *m->names);
+  m->functions = allocate(m->functions,
+    (c.function_count + 1) * sizeof *m->functions);
+  m->constants = allocate(m->constants,
+    (c.constants_count + 1) * sizeof *m->constants);
+  if (!io_transfer(fd, m->tokens, c.count * sizeof *m->tokens, 0) ||
+  !io_transfer(fd, m->lines, c.lines_count * sizeof *m->lines, 0) ||
+  !io_transfer(fd, m->strings, c.strings_size, 0) ||
+  !io_transfer(fd, m->names, c.variable_count * sizeof *m->names, 0) ||
+  !io_transfer(fd, m->functions,
+    c.function_count * sizeof *m->functions, 0) ||
+  !io_transfer(fd, m->constants,
+    c.constants_count * sizeof *m->constants, 0) ||
+  !c.count || m->tokens[c.count - 1].token != T_EOF)
+    return 0;
+  m->count           = c.count;
+  m->lines_count     = c.lines_count;
+  m->strings_size    = c.strings_size;
+  m->variable_count  = c.variable_count;
+  m->function_count  = c.function_count;
+  m->constants_count = c.constants_count;
+  return 1;
+}
+
+#endif
+
+/**
+ * scan_chunks
+ *
+ * @param p An empty program.
+ * @return Was the source scanned, in chunks? If not, it is scanned
+ *         whole; always, without POSIX.
+ */
+
+static int scan_chunks (struct program *p)
+{
+#ifdef VVTBI_POSIX
+  struct program *m;
+  pid_t           workers[VVTBI_LOAD_WORKERS];
+  int             pipes[VVTBI_LOAD_WORKERS], fd[2];
+  size_t          starts[VVTBI_LOAD_WORKERS + 1], end;
+  long            cores;
+  int             k, j, w;
+
+  /* A chunk per core, each of VVTBI_LOAD_CHUNK characters at
+     least. */
+  cores = sysconf(_SC_NPROCESSORS_ONLN);
+  if (!program_parallel || cores < 2 || p->length / VVTBI_LOAD_CHUNK < 2)
+    return 0;
+  w = cores > VVTBI_LOAD_WORKERS ? VVTBI_LOAD_WORKERS : (int) cores;
+  if ((size_t) w > p->length / VVTBI_LOAD_CHUNK)
+    w = (int) (p->length / VVTBI_LOAD_CHUNK);
+  /* Chunks split after a new-line that a line number follows,
+     as the scanner starts each chunk at a line's start. */
+  starts[0] = 0;
+  for (k = 1, j = 1; k < w; k++)
+  {
+    end = p->length * k / w;
+    if (end <= starts[j - 1])
+      end = starts[j - 1] + 1;
+    while (end < p->length && (p->source[end - 1] != '\n' ||
+    !isdigit((unsigned char) p->source[end])))
+      end++;
+    if (end < p->length)
+      starts[j++] = end;
+  }
+  w         = j;
+  starts[w] = p->length;
+  if (w < 2)
+    return 0;
+  /* The first chunk is scanned here, the rest by workers; what
+     is buffered is written first, or each would write it too. */
+  fflush(stdout);
+  for (k = 1; k < w; k++)
+  {
+    workers[k] = -1;
+    pipes[k]   = -1;
+    if (pipe(fd))
+      continue;
+    workers[k] = fork();
+    if (workers[k] == 0)
+    {
+      /* The worker: it owns the scanner, no need to share it. */
+      close(fd[0]);
+      m = create(p->file, NULL, 0);
+      scan(m, p->source + starts[k], starts[k + 1] - starts[k]);
+      _exit(send_chunk(fd[1], m) ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+    close(fd[1]);
+    if (workers[k] < 0)
+      close(fd[0]);
+    else
+      pipes[k] = fd[0];
+  }
+  for (k = 0; k < w; k = j)
+  {
+    /* A worker lost, or never started, is its chunk scanned
+       here. */
+    m = create(p->file, NULL, 0);
+    if (!k || pipes[k] < 0 || !receive_chunk(pipes[k], m))
+    {
+      program_release(m);
+      m = create(p->file, NULL, 0);
+      scan(m, p->source + starts[k], starts[k + 1] - starts[k]);
+    }
+    /* A chunk that ends within a string literal does not end on
+       a T_EOL: its string goes on in the next, which is scanned
+       with it here. */
+    for (j = k + 1; j < w && (m->count < 2 ||
+    m->tokens[m->count - 2].token != T_EOL); j++)
+    {
+      program_release(m);
+      m = create(p->file, NULL, 0);
+      scan(m, p->source + starts[k], starts[j + 1] - starts[k]);
+    }
+    stitch(p, m, starts[k], j == w);
+    program_release(m);
+  }
+  /* Workers whose chunk was scanned here are not read to the
+     end, and are killed. */
+  for (k = 1; k < w; k++)
+  {
+    if (pipes[k] >= 0)
+      close(pipes[k]);
+    if (workers[k] > 0)
+    {
+      kill(workers[k], SIGKILL);
+      waitpid(workers[k], NULL, 0);
+    }
+  }
+  return 1;
+#else
+  (void) p;
+  return 0;
+#endif
+}
+
+/**
+ * program_compile
+ *
+ * @param name The name of the source code.
+ * @param source The source code, which the program takes over.
+ * @param n The length of the source code.
+ * @return p The compiled program.
+ */
+
+struct program *program_compile (const char *name, char *source, size_t n)
+{
+  struct program *p;
+  size_t          i;
+
+  p = create(name, source, n);
+  sample_phase = S_LEX;
+  stats.characters += n;
+  /* Large sources are scanned in chunks, in parallel. */
+  if (!scan_chunks(p))
+    scan(p, source, n);
+  for (i = 0; i < p->count; i++)
+    stats.tokens[p->tokens[i].token]++;
+  include_modules(p);
+  index_lines(p);
+  layout_arrays(p);
+  pack_data(p);
+  infer_types(p);
+  prove_divisions(p);
+  sample_phase = S_STATEMENT;
+  return p;
+}
+
+/**
+ * status
+ *
+ * @param file A source code file.
+ * @param info Destination of its status.
+ * @return Is its status known? Never without POSIX.
+ */
+
+static int status (const char *file, struct file_status *info)
+{
+#ifdef VVTBI_POSIX
+  struct stat st;
+  if (stat(file, &st))
+    return 0;
+  info->mtime      = (long) st.st_mtim.tv_sec;
+  info->mtime_nsec = (long) st.st_mtim.tv_nsec;
+  info->size       = (size_t) st.st_size;
+  return 1;
+#else
+  (void) file;
+  (void) info;
+  return 0;
+#endif
+}
+
+/**
+ * fresh
+ *
+ * @param p A cached program.
+ * @param info The status of its file, or NULL to look it up.
+ * @return Are the program's file, and its modules', unchanged since
+ *         it was compiled, by their size and time of change?
+ */
+
+static int fresh (const struct program *p, const struct file_status *info)
+{
+  struct file_status own;
+  size_t             i;
+  if (!info && !status(p->file, &own))
+    return 0;
+  if (!info)
+    info = &own;
+  if (p->mtime < 0 || p->mtime != info->mtime ||
+  p->mtime_nsec != info->mtime_nsec || p->size != info->size)
+    return 0;
+  for (i = 0; i < p->module_count; i++)
+    if (!fresh(p->modules[i], NULL))
+      return 0;
+  return 1;
+}
+
+/**
+ * cached
+ *
+ * @param source The name of the source code.
+ * @param buffer The source code, which the program takes over.
+ * @param n The length of the source code.
+ * @param info The status of its file, or NULL if it has none.
+ * @return p The compiled program, from the cache if possible.
+ */
+
+static struct program *cached (const char *source, char *buffer,
+  size_t n, const struct file_status *info)
+{
+  struct cache_entry *entry, *oldest;
+  struct program     *p;
+  unsigned long       hash;
+  size_t              i;
+
+  hash = program_hash(buffer, n);
+  /* Look for an identical source of the same file in the cache,
+     its modules unchanged: INCLUDE and CHAIN find their files
+     beside it, and another's would be another program. */
+  for (i = 0; i < VVTBI_PROGRAM_CACHE; i++)
+  {
+    entry = &cache[i];
+    p     = entry->program;
+    if (p && p->hash == hash && p->size == n &&
+    !strcmp(p->file, source) && !memcmp(p->source, buffer, n) &&
+    (!p->module_count || fresh(p, NULL)))
+    {
+      /* Cache hit! The source needn't be scanned again. */
+      free(buffer);
+      entry->used = uses;
+      p->refs++;
+      return p;
+    }
+  }
+  /* Cache miss, compile and evict the least-recently-used; its
+     modules are loaded, and cached, first. */
+  p = program_compile(source, buffer, n);
+  if (p->data_error >= 0)
+  {
+    fprintf(stderr,
+      "*program.c: `%s' line %ld: a DATA item is not an int!\n",
+      source, p->data_error);
+    exit(EXIT_FAILURE);
+  }
+  /* A file modified this second may be again within it, its
+     time unchanged where times are coarse: read it each time
+     until its time is past. */
+  if (info && info->mtime < (long) time(NULL) - 1)
+  {
+    p->mtime      = info->mtime;
+    p->mtime_nsec = info->mtime_nsec;
+  }
+  for (i = 0, oldest = cache; i < VVTBI_PROGRAM_CACHE; i++)
+  {
+    entry = &cache[i];
+    if (!entry->program ||
+    (oldest->program && entry->used < oldest->used))
+      oldest = entry;
+  }
+  if (oldest->program)
+    program_release(oldest->program);
+  oldest->program = p;
+  oldest->used    = uses;
+  /* One reference for the cache, one for the caller. */
+  p->refs++;
+  return p;
+}
+
+/**
+ * program_load
+ *
+ * @param source Source code file.
+ * @return p The compiled program, from the cache if possible.
+ */
+
+struct program *program_load (const char *source)
+{
+  struct cache_entry *entry;
+  struct program     *p;
+  struct file_status  info;
+  char               *buffer;
+  size_t              n, i;
+  int                 known;
+
+  uses++;
+  /* A file unchanged by path, size and time needn't be read. */
+  known = status(source, &info);
+  for (i = 0; known && i < VVTBI_PROGRAM_CACHE; i++)
+  {
+    entry = &cache[i];
+    p     = entry->program;
+    if (p && !strcmp(p->file, source) && fresh(p, &info))
+    {
+      entry->used = uses;
+      p->refs++;
+      return p;
+    }
+  }
+  buffer = io_read(source, &n);
+  if (!buffer)
+    exit(EXIT_FAILURE);
+  return cached(source, buffer, n, known ? &info : NULL);
+}
+
+/**
+ * program_source
+ *
+ * @param name The name of the source code, that its INCLUDEs
+ *             and CHAINs are found beside.
+ * @param source The source code, which the program takes over.
+ * @param n The length of the source code.
+ * @return p The compiled program, from the cache if possible.
+ */
+
+struct program *program_source (const char *name, char *source, size_t n)
+{
+  uses++;
+  return cached(name, source, n, NULL);
+}
+
+/**
+ * program_release
+ *
+ * @param p The program to release.
+ * @return void
+ */
+
+void program_release (struct program *p)
+{
+  if (--p->refs > 0)
+    return;
+  free(p->file);
+  free(p->source);
+  free(p->tokens);
+  free(p->strings);
+  free(p->lines);
+  free(p->index);
+  free(p->keys);
+  free(p->arrays);
+  free(p->names);
+  free(p->slots);
+  free(p->types);
+  free(p->constants);
+  free(p->functions);
+  free(p->data);
+  while (p->module_count)
+    program_release(p->modules[--p->module_count]);
+  free(p->modules);
+  free(p);
+}
+
+/**
+ * program_edit
+ *
+ * @param p The program, compiled by program_compile and not shared.
+ * @param number The number of the line to replace, insert or delete.
+ * @param text The line's new text, up to the next numbered line,
+ *             or NULL to delete it.
+ * @param n The length of text.
+ * @return Was the line edited? The text must be one line, numbered.
+ */
+
+int program_edit (struct program *p, int number, const char *text,
+  size_t n)
+{
+  struct program       *f;
+  struct program_token *t;
+  char                 *source;
+  long                  k, delta, shift;
+  size_t                i, j, first, last, count, base, pool;
+
+  /* Compile the line alone. */
+  f     = NULL;
+  count = 0;
+  if (text)
+  {
+    source = allocate(NULL, n + 2);
+    memcpy(source, text, n);
+    /* A line ends with a new-line, even the last. */
+    if (!n || (text[n - 1] != '\n' && text[n - 1] != '\r'))
+      source[n++] = '\n';
+    source[n] = 0;
+    f = program_compile(p->file, source, n);
+    if (f->lines_count != 1 || f->lines[0].start != 0 ||
+    f->lines[0].number != number)
+    {
+      program_release(f);
+      return 0;
+    }
+    /* Its T_EOF is not kept. */
+    count = f->count - 1;
+  }
+  k = program_index(p, number);
+  if (k < 0 && !f)
+    return 0;
+  /* A new line goes before the first numbered after it. */
+  j = (size_t) k;
+  if (k < 0)
+    for (j = 0; j < p->lines_count && p->lines[j].number < number; j++)
+      ;
+  first = j < p->lines_count ? p->lines[j].start : p->count - 1;
+  last  = first;
+  if (k >= 0)
+    last = j + 1 < p->lines_count ? p->lines[j + 1].start : p->count - 1;
+  delta = (long) count - (long) (last - first);
+  shift = (f != NULL) - (k >= 0);
+
+  /* Move the tokens after the line: nothing else is scanned. */
+  if (delta > 0)
+    p->tokens = allocate(p->tokens,
+      (p->count + delta) * sizeof *p->tokens);
+  memmove(&p->tokens[last + delta], &p->tokens[last],
+    (p->count - last) * sizeof *p->tokens);
+  p->count += delta;
+  for (i = first + count; i < p->count; i++)
+    if (p->tokens[i].line >= 0)
+      p->tokens[i].line += shift;
+
+  /* Patch the line table, and the jumps resolved into it. */
+  if (shift > 0)
+  {
+    p->lines = allocate(p->lines,
+      (p->lines_count + 1) * sizeof *p->lines);
+    memmove(&p->lines[j + 1], &p->lines[j],
+      (p->lines_count - j) * sizeof *p->lines);
+    p->lines_count++;
+  }
+  else if (shift < 0)
+  {
+    memmove(&p->lines[j], &p->lines[j + 1],
+      (p->lines_count - j - 1) * sizeof *p->lines);
+    p->lines_count--;
+  }
+  for (i = 0; i < p->lines_count; i++)
+  {
+    if (i > j || (i == j && !f))
+      p->lines[i].start += delta;
+    if (p->lines[i].target > (long) first ||
+    (p->lines[i].target == (long) first && k < 0))
+      p->lines[i].target += delta;
+    else if (p->lines[i].target == (long) first && !f)
+      p->lines[i].target = -1;
+  }
+  if (!f)
+  {
+    index_lines(p);
+    layout_arrays(p);
+    pack_data(p);
+    infer_types(p);
+    prove_divisions(p);
+    return 1;
+  }
+  p->lines[j].number = number;
+  p->lines[j].start  = first;
+  p->lines[j].target = -1;
+  index_lines(p);
+
+  /* Splice in the line's tokens, its strings and its text. */
+  base = p->length;
+  pool = p->strings_size;
+  for (i = 0; i < count; i++)
+  {
+    t  = &p->tokens[first + i];
+    *t = f->tokens[i];
+    t->offset += base;
+    if (t->token == T_STRING)
+      t->value += (int) pool;
+    if (t->line >= 0)
+      t->line = (int) j;
+  }
+  if (f->strings_size)
+  {
+    p->strings = allocate(p->strings, pool + f->strings_size);
+    memcpy(p->strings + pool, f->strings, f->strings_size);
+    p->strings_size += f->strings_size;
+  }
+  /* The line's variables and functions keep their names, not
+     their numbers, and its numbers go after the constants. */
+  for (i = 0; i < count; i++)
+  {
+    t = &p->tokens[first + i];
+    if (t->token == T_LETTER)
+      t->value = intern(p, f->strings + f->names[t->value]);
+    else if (t->token == T_FUNCTION)
+      t->value = add_function(p, f->strings + f->functions[t->value]);
+    else if (t->token == T_WIDE || t->token == T_DECIMAL)
+      t->value = add_constant(p, f->constants[t->value]);
+  }
+  p->source  = allocate(p->source, base + f->length + 1);
+  memcpy(p->source + base, f->source, f->length + 1);
+  p->length += f->length;
+  p->tokens[p->count - 1].offset = (long) p->length;
+  program_release(f);
+  layout_arrays(p);
+  pack_data(p);
+  infer_types(p);
+  prove_divisions(p);
+  return 1;
+}
+
+/**
+ * program_index
+ *
+ * @param p The program.
+ * @param number The line number to find.
+ * @return i The index of the line in the line table, or -1.
+ */
+
+long program_index (const struct program *p, int number)
+{
+  size_t k;
+  /* Compact: one look. */
+  if (!p->keys)
+  {
+    stats.scanned += sizeof *p->index;
+    if (number < p->base ||
+    (unsigned long) number - p->base >= p->index_size)
+      return -1;
+    return p->index[number - p->base];
+  }
+  /* Sparse: down the tree, left if number is not greater. */
+  for (k = 1; k <= p->index_size; k = 2 * k + (p->keys[k] < number))
+    stats.scanned += sizeof *p->keys;
+  /* Back up past the right turns, and the last left: that
+     is the least key not less than number. */
+  while (k & 1)
+    k >>= 1;
+  k >>= 1;
+  if (!k || p->keys[k] != number)
+    return -1;
+  return p->index[k];
+}
+
+/**
+ * program_find
+ *
+ * @param p The program.
+ * @param number The line number to find.
+ * @return The index of the line's token, or -1.
+ */
+
+long program_find (const struct program *p, int number)
+{
+  long i;
+  i = program_index(p, number);
+  return i < 0 ? -1 : (long) p->lines[i].start;
+}
+
+/**
+ * program_jump
+ *
+ * @param p The program.
+ * @param line The index of a line in the line table.
+ * @return The index of the token the line's GOTO, GOSUB or IF
+ *         jumps to, or -1.
+ */
+
+long program_jump (const struct program *p, long line)
+{
+  size_t i;
+  /* A jump's line number follows GOTO, GOSUB or THEN. */
+  for (i = p->lines[line].start + 1;
+  p->tokens[i].token != T_EOL && p->tokens[i].token != T_EOF; i++)
+    if ((p->tokens[i].token == T_GOTO ||
+    p->tokens[i].token == T_GOSUB ||
+    p->tokens[i].token == T_THEN) &&
+    p->tokens[i + 1].token == T_NUMBER)
+      return program_find(p, p->tokens[i + 1].value);
+  return -1;
+}
+
+/**
+ * program_variable
+ *
+ * @param p The program.
+ * @param name A variable's name.
+ * @return The variable's slot, or -1 if the program has none.
+ */
+
+int program_variable (const struct program *p, const char *name)
+{
+  return p->slots[find_slot(p, name)];
+}
+
+/**
+ * program_name
+ *
+ * @param p The program.
+ * @param variable A variable's slot.
+ * @return The variable's name.
+ */
+
+const char *program_name (const struct program *p, int variable)
+{
+  return p->strings + p->names[variable];
+}
+
+/**
+ * program_widen
+ *
+ * @param p The program.
+ * @param variable A variable's slot.
+ * @param type The type it must hold at least, say, to be given a
+ *             value from elsewhere.
+ * @return void
+ */
+
+void program_widen (struct program *p, int variable, int type)
+{
+  if (type <= p->types[variable])
+    return;
+  p->types[variable] = (char) type;
+  infer_types(p);
+  prove_divisions(p);
+}
+
+/**
+ * program_function
+ *
+ * @param p The program.
+ * @param function A host function's number.
+ * @return The function's name.
+ */
+
+const char *program_function (const struct program *p, int function)
+{
+  return p->strings + p->functions[function];
+}
+
+/**
+ * program_module
+ *
+ * @param p The running program.
+ * @param name A file, relative to the program's, to CHAIN to.
+ * @return The file's compiled program, from the cache if possible.
+ */
+
+struct program *program_module (const struct program *p, const char *name)
+{
+  struct program *m;
+  char           *path;
+  path = module_path(p, name);
+  m    = program_load(path);
+  free(path);
+  return m;
+}
\ No newline at end of file
@@ -0,0 +1,139 @@
+/*************************************
+   program.h, @format.new-line  lf
+              @format.use-tabs  false
+   @format.tab-size    2
+   @format.indent-size 2
+   @format.line-length 80
+**************************************/
+#ifndef _PROGRAM_H__
+#define _PROGRAM_H__
+
+/* Token flags, found at load: an array index proven in bounds,
+   the first token of an expression, or the statement, to be
+   run on typed values rather than int, and a / whose divisor
+   is proven never zero. */
+#define PROGRAM_IN_BOUNDS 1
+#define PROGRAM_TYPED     2
+#define PROGRAM_NONZERO   4
+
+/* The types of variables and expressions, inferred at load;
+   each holds those before it. Wide numbers are long, 64-bit
+   where long is; decimals are wide, in VVTBI_DECIMAL_SCALE. */
+enum {
+  PROGRAM_INTEGER, PROGRAM_WIDE, PROGRAM_DECIMAL
+};
+
+/* A scanned token and its datum: the number, the variable's
+   slot, the offset of the string in the string pool, the
+   index of the wide or decimal number in the constants or,
+   for the name after CALL, a T_FUNCTION, the function's.
+   line is the index of the token's numbered line, or -1. */
+struct program_token {
+  int  token;
+  int  value;
+  int  line;
+  int  flags;
+  long offset;
+};
+
+/* A line number, the index of its token and, if resolved ahead
+   of time, the index of the token its GOTO, GOSUB or IF
+   jumps to. */
+struct program_line {
+  int    number;
+  size_t start;
+  long   target;
+};
+
+/* An array's place in the arena, and its length: DIM a(n)
+   gives it n + 1 elements, from a(0). */
+struct program_array {
+  size_t base;
+  size_t length;
+};
+
+/* A compiled program: its source scanned once, into memory.
+   The line table is indexed by number: directly, from base, if
+   the numbers are compact; else keys holds the numbers in
+   Eytzinger order, from 1, to binary search. Variables are
+   numbered densely, in order of appearance, through the
+   open-addressed table slots; names holds each one's name in
+   the string pool, and types its type. The arrays, a place per
+   variable, share one arena of arena_size. The host functions
+   CALLed are numbered likewise, their names in functions.
+   The modules INCLUDEd are merged in, their text after the
+   file's own size characters; the program keeps a reference
+   to each, to tell if it is still fresh: unchanged since its
+   modification time, mtime and mtime_nsec, or -1 if it must
+   be read to tell. The items of its DATA lines are packed into
+   data, in order; data_error is the number of the first line
+   with an item not an int, or -1. */
+struct program {
+  char                 *file;
+  char                 *source;
+  size_t                length;
+  size_t                size;
+  long                  mtime;
+  long                  mtime_nsec;
+  unsigned long         hash;
+  struct program_token *tokens;
+  size_t                count;
+  char                 *strings;
+  size_t                strings_size;
+  struct program_line  *lines;
+  size_t                lines_count;
+  int                  *index;
+  int                  *keys;
+  size_t                index_size;
+  int                   base;
+  size_t               *names;
+  size_t                variable_count;
+  int                  *slots;
+  size_t                slots_size;
+  char                 *types;
+  long                 *constants;
+  size_t                constants_count;
+  struct program_array *arrays;
+  size_t                arena_size;
+  size_t               *functions;
+  size_t                function_count;
+  struct program      **modules;
+  size_t                module_count;
+  int                  *data;
+  size_t                data_count;
+  long                  data_error;
+  int                   refs;
+};
+
+/* Are variables at least wide, rather than int? See -int64. */
+extern int program_wide;
+
+/* May large sources be scanned by forked workers? Not while
+   another thread runs: see -async-output. */
+extern int program_parallel;
+
+struct program *program_load    (const char *source);
+struct program *program_source  (const char *name, char *source,
+                                 size_t n);
+struct program *program_compile (const char *name, char *source,
+                                 size_t n);
+void            program_release (struct program *p);
+int             program_edit    (struct program *p, int number,
+                                 const char *text, size_t n);
+long            program_find    (const struct program *p, int number);
+long            program_index   (const struct program *p, int number);
+long            program_jump    (const struct program *p, long line);
+unsigned long   program_hash    (const char *source, size_t n);
+int             program_variable
+                                (const struct program *p,
+                                 const char *name);
+const char     *program_name    (const struct program *p, int variable);
+void            program_widen   (struct program *p, int variable,
+                                 int type);
+const char     *program_function
+                                (const struct program *p,
+                                 int function);
+struct program *program_module  (const struct program *p,
+                                 const char *name);
+
+#endif /* _PROGRAM_H__ */
\ No newline at end of file
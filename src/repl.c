@@ -0,0 +1,474 @@
+/**********************************
+   repl.c, @format.new-line  lf
+           @format.use-tabs  false
+   @format.tab-size    2
+   @format.indent-size 2
+   @format.line-length 80
+***********************************/
+/* stat's st_mtim and nanosleep are POSIX, not ANSI. */
+#ifdef VVTBI_POSIX
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <time.h>
+#ifdef VVTBI_POSIX
+#include <sys/stat.h>
+#endif
+
+#include "config.h"
+#include "io.h"
+#include "program.h"
+#include "check.h"
+#include "vvtbi.h"
+#include "repl.h"
+
+/* The longest line the REPL reads. */
+#define REPL_LINE 1024
+
+/* The interval, in milliseconds, between looks at a watched file. */
+#define REPL_WATCH 200
+
+/* The variables, kept between runs for inspection: by name,
+   for each program numbers its own, with their types. */
+static char  (*names)[VVTBI_NAME_LENGTH + 1] = NULL;
+static char   *types          = NULL;
+static long   *values         = NULL;
+static size_t  variable_count = 0;
+
+/******************************************************************************/
+
+/**
+ * compile
+ *
+ * @param name The name of the source code.
+ * @param text The source code, or NULL.
+ * @param n The length of the source code.
+ * @return p The compiled program, from a copy of text.
+ */
+
+static struct program *compile (const char *name, const char *text,
+  size_t n)
+{
+  char *source;
+  if (!(source = malloc(n + 1)))
+  {
+    fprintf(stderr, "*repl.c: out of memory!\n");
+    exit(EXIT_FAILURE);
+  }
+  if (n)
+    memcpy(source, text, n);
+  source[n] = 0;
+  return program_compile(name, source, n);
+}
+
+/**
+ * keep
+ *
+ * @param name A variable's name.
+ * @param type Its type.
+ * @param value Its value, in its type.
+ * @return void
+ */
+
+static void keep (const char *name, int type, long value)
+{
+  size_t i;
+  for (i = 0; i < variable_count && strcmp(names[i], name); i++)
+    ;
+  if (i == variable_count)
+  {
+    names  = realloc(names, (i + 1) * sizeof *names);
+    types  = realloc(types, i + 1);
+    values = realloc(values, (i + 1) * sizeof *values);
+    if (!names || !types || !values)
+    {
+      fprintf(stderr, "*repl.c: out of memory!\n");
+      exit(EXIT_FAILURE);
+    }
+    strcpy(names[variable_count++], name);
+  }
+  types[i]  = (char) type;
+  values[i] = value;
+}
+
+/**
+ * run
+ *
+ * @param p The program.
+ * @return void
+ */
+
+static void run (struct program *p)
+{
+  struct vvtbi_context ctx;
+  size_t               i;
+  int                  slot;
+  /* Report every error, rather than stop at the first. */
+  if (check_program(p, stderr))
+    return;
+  /* A variable kept must be as wide as its value. */
+  for (i = 0; i < variable_count; i++)
+    if ((slot = program_variable(p, names[i])) >= 0)
+      program_widen(p, slot, types[i]);
+  /* The context's reference is its own. */
+  p->refs++;
+  vvtbi_attach(&ctx, p);
+  for (i = 0; i < variable_count; i++)
+  {
+    if ((slot = program_variable(p, names[i])) < 0)
+      continue;
+    if (p->types[slot] == PROGRAM_INTEGER)
+      ctx.variables[slot] = (int) values[i];
+    else if (p->types[slot] == PROGRAM_DECIMAL &&
+    types[i] != PROGRAM_DECIMAL)
+      ctx.wides[slot] = values[i] * VVTBI_DECIMAL_SCALE;
+    else
+      ctx.wides[slot] = values[i];
+  }
+  while (!ctx.finished)
+    vvtbi_step(&ctx, VVTBI_SCHEDULER_BUDGET);
+  /* After a CHAIN, the context's program is another. */
+  for (i = 0; i < ctx.variable_count; i++)
+    keep(program_name(ctx.program, (int) i), ctx.program->types[i],
+      ctx.program->types[i] == PROGRAM_INTEGER ? ctx.variables[i] :
+      ctx.wides[i]);
+  vvtbi_release(&ctx);
+  fflush(stdout);
+}
+
+#ifdef VVTBI_POSIX
+/**
+ * split
+ *
+ * @param source The source code.
+ * @param n The length of the source code.
+ * @param count Destination of the amount of numbered lines.
+ * @param preamble Destination of the length before the first.
+ * @return chunks The numbered lines, or NULL if there are none.
+ */
+
+static struct repl_chunk *split (const char *source, size_t n,
+  size_t *count, size_t *preamble)
+{
+  struct repl_chunk *chunks, *c;
+  size_t             i, start, size;
+  int                digits;
+
+  chunks    = NULL;
+  size      = 0;
+  *count    = 0;
+  *preamble = n;
+  for (i = 0; i < n; )
+  {
+    /* A line beginning with a number begins a chunk. */
+    for (start = i; i < n && (source[i] == ' ' || source[i] == '\t'); i++)
+      ;
+    if (i < n && isdigit((unsigned char) source[i]))
+    {
+      if (*count == size)
+      {
+        size   = size ? size * 2 : 64;
+        chunks = realloc(chunks, size * sizeof *chunks);
+        if (!chunks)
+        {
+          fprintf(stderr, "*repl.c: out of memory!\n");
+          exit(EXIT_FAILURE);
+        }
+      }
+      c         = &chunks[(*count)++];
+      c->text   = source + i;
+      c->number = 0;
+      for (digits = 0; i < n && isdigit((unsigned char) source[i]);
+      i++, digits++)
+        c->number = c->number * 10 + (source[i] - '0');
+      /* Too long to be a line number; let the scanner say so. */
+      if (digits > VVTBI_NUMBER_LITERAL)
+        c->number = -1;
+      if (*count == 1)
+        *preamble = start;
+      else
+        c[-1].length = start - (c[-1].text - source);
+    }
+    /* Skip to the next line. */
+    for (; i < n && source[i] != '\n' && source[i] != '\r'; i++)
+      ;
+    if (i < n && source[i] == '\r' && i + 1 < n && source[i + 1] == '\n')
+      i++;
+    i++;
+  }
+  if (*count)
+    chunks[*count - 1].length = n - (chunks[*count - 1].text - source);
+  return chunks;
+}
+
+/**
+ * sorted
+ *
+ * @param chunks The numbered lines.
+ * @param count The amount of numbered lines.
+ * @return Are they numbered in ascending order, each once?
+ */
+
+static int sorted (const struct repl_chunk *chunks, size_t count)
+{
+  size_t i;
+  for (i = 0; i < count; i++)
+    if (chunks[i].number < 0 ||
+    (i > 0 && chunks[i].number <= chunks[i - 1].number))
+      return 0;
+  return 1;
+}
+
+/**
+ * patch
+ *
+ * @param p The program compiled from the old source.
+ * @param old The old source.
+ * @param old_n The length of the old source.
+ * @param new The new source.
+ * @param new_n The length of the new source.
+ * @return The amount of lines recompiled, or -1 if the
+ *         program must be compiled anew.
+ */
+
+static long patch (struct program *p, const char *old, size_t old_n,
+  const char *new, size_t new_n)
+{
+  struct repl_chunk *a, *b;
+  size_t             a_count, b_count, a_pre, b_pre, i, j;
+  long               edits;
+
+  a     = split(old, old_n, &a_count, &a_pre);
+  b     = split(new, new_n, &b_count, &b_pre);
+  edits = 0;
+  /* Edits are made by line number: that needs both to be in
+     order, and whatever precedes the first line unchanged. */
+  if (!sorted(a, a_count) || !sorted(b, b_count) ||
+  a_pre != b_pre || memcmp(old, new, a_pre))
+    edits = -1;
+  /* Merge the old and new lines by number. */
+  for (i = j = 0; edits >= 0 && (i < a_count || j < b_count); )
+  {
+    if (j == b_count ||
+    (i < a_count && a[i].number < b[j].number))
+    {
+      if (!program_edit(p, a[i].number, NULL, 0))
+        edits = -1;
+      else
+        edits++;
+      i++;
+    }
+    else if (i == a_count || b[j].number < a[i].number ||
+    a[i].length != b[j].length ||
+    memcmp(a[i].text, b[j].text, a[i].length))
+    {
+      if (!program_edit(p, b[j].number, b[j].text, b[j].length))
+        edits = -1;
+      else
+        edits++;
+      if (i < a_count && a[i].number == b[j].number)
+        i++;
+      j++;
+    }
+    /* Unchanged. */
+    else
+    {
+      i++;
+      j++;
+    }
+  }
+  free(a);
+  free(b);
+  return edits;
+}
+
+/**
+ * changed
+ *
+ * @param file The watched file.
+ * @param last The file's status when last looked at.
+ * @return Has the file changed since?
+ */
+
+static int changed (const char *file, struct stat *last)
+{
+  struct stat now;
+  if (stat(file, &now))
+    return 0;
+  if (now.st_size == last->st_size &&
+  now.st_mtim.tv_sec == last->st_mtim.tv_sec &&
+  now.st_mtim.tv_nsec == last->st_mtim.tv_nsec)
+    return 0;
+  *last = now;
+  return 1;
+}
+
+/**
+ * repl_watch
+ *
+ * @param file The source code file.
+ * @return Did the file stay readable? Otherwise, runs forever.
+ */
+
+int repl_watch (const char *file)
+{
+  struct program *p;
+  struct timespec interval;
+  struct stat     last;
+  char           *source, *updated;
+  size_t          n, m;
+  long            edits;
+
+  if (stat(file, &last) || !(source = io_read(file, &n)))
+    return 0;
+  interval.tv_sec  = REPL_WATCH / 1000;
+  interval.tv_nsec = REPL_WATCH % 1000 * 1000000L;
+  p = compile(file, source, n);
+  variable_count = 0;
+  run(p);
+  for (;;)
+  {
+    nanosleep(&interval, NULL);
+    if (!changed(file, &last))
+      continue;
+    if (!(updated = io_read(file, &m)))
+      continue;
+    /* Recompile only the lines edited... */
+    edits = patch(p, source, n, updated, m);
+    if (edits < 0)
+    {
+      /* ...unless the edit cannot be made by line number. */
+      program_release(p);
+      p     = compile(file, updated, m);
+      edits = (long) p->lines_count;
+    }
+    fprintf(stderr, "--- %s: %ld of %lu lines compiled ---\n",
+      file, edits, (unsigned long) p->lines_count);
+    free(source);
+    source = updated;
+    n      = m;
+    variable_count = 0;
+    run(p);
+  }
+}
+
+#else
+/**
+ * repl_watch
+ *
+ * @param file The source code file.
+ * @return 0, a file cannot be watched without POSIX.
+ */
+
+int repl_watch (const char *file)
+{
+  (void) file;
+  fprintf(stderr, "*repl.c: -watch is unavailable on this platform\n");
+  return 0;
+}
+#endif
+
+/**
+ * list
+ *
+ * @param p The program.
+ * @return void
+ */
+
+static void list (const struct program *p)
+{
+  const char *text;
+  size_t      i, n;
+  /* Each line is one piece of the source, wherever it was
+     edited, beginning at its number. */
+  for (i = 0; i < p->lines_count; i++)
+  {
+    text = p->source + p->tokens[p->lines[i].start].offset;
+    n    = strcspn(text, "\r\n");
+    printf("%.*s\n", (int) n, text);
+  }
+}
+
+/**
+ * repl_run
+ *
+ * @param file The source code file to begin with, or NULL.
+ * @return Was the file readable?
+ */
+
+int repl_run (const char *file)
+{
+  struct program *p, *immediate;
+  char            input[REPL_LINE + 3], *command, *source;
+  const char     *name;
+  size_t          n;
+  int             number;
+
+  name = file ? file : "repl";
+  if (!file)
+    p = compile(name, NULL, 0);
+  else if ((source = io_read(file, &n)))
+  {
+    p = compile(name, source, n);
+    free(source);
+  }
+  else
+    return 0;
+  variable_count = 0;
+  for (;;)
+  {
+    printf("> ");
+    fflush(stdout);
+    if (!fgets(input, REPL_LINE, stdin))
+      break;
+    for (command = input; *command == ' ' || *command == '\t'; command++)
+      ;
+    n = strcspn(command, "\r\n");
+    command[n] = 0;
+    if (!n)
+      continue;
+    /* A numbered line is recompiled alone, and patched in;
+       a number alone deletes its line. */
+    if (isdigit((unsigned char) *command))
+    {
+      number = atoi(command);
+      if (!command[strspn(command, "0123456789 \t")])
+      {
+        if (!program_edit(p, number, NULL, 0))
+          fprintf(stderr, "*repl.c: no line %d\n", number);
+      }
+      else if (!program_edit(p, number, command, n))
+        fprintf(stderr, "*repl.c: `%s' is not a line\n", command);
+    }
+    else if (!strcmp(command, "RUN"))
+    {
+      variable_count = 0;
+      run(p);
+    }
+    else if (!strcmp(command, "LIST"))
+      list(p);
+    else if (!strcmp(command, "NEW"))
+    {
+      program_release(p);
+      p = compile(name, NULL, 0);
+    }
+    else if (!strcmp(command, "QUIT"))
+      break;
+    /* Anything else is run at once, as line 0. */
+    else
+    {
+      memmove(command + 2, command, n);
+      memcpy(command, "0 ", 2);
+      command[n + 2] = '\n';
+      immediate = compile(name, command, n + 3);
+      run(immediate);
+      program_release(immediate);
+    }
+  }
+  program_release(p);
+  return 1;
+}
\ No newline at end of file
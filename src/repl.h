@@ -0,0 +1,22 @@
+/**********************************
+   repl.h, @format.new-line  lf
+           @format.use-tabs  false
+   @format.tab-size    2
+   @format.indent-size 2
+   @format.line-length 80
+***********************************/
+#ifndef _REPL_H__
+#define _REPL_H__
+
+/* A numbered line of a source file, and any
+   unnumbered lines up to the next. */
+struct repl_chunk {
+  int         number;
+  const char *text;
+  size_t      length;
+};
+
+int repl_run   (const char *file);
+int repl_watch (const char *file);
+
+#endif /* _REPL_H__ */
\ No newline at end of file
@@ -0,0 +1,174 @@
+/************************************
+   sample.c, @format.new-line  lf
+             @format.use-tabs  false
+   @format.tab-size    2
+   @format.indent-size 2
+   @format.line-length 80
+*************************************/
+/* setitimer and sigaction are POSIX, not ANSI. */
+#ifdef VVTBI_POSIX
+#define _XOPEN_SOURCE 500
+#endif
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+
+#ifdef VVTBI_POSIX
+#include <sys/time.h>
+#endif
+
+#include "config.h"
+#include "sample.h"
+
+volatile sig_atomic_t sample_phase = S_STATEMENT;
+volatile sig_atomic_t sample_line  = -1;
+
+/* Phase names, as written to folded stacks. */
+static const char *phase_strings[] =
+{
+  "statement",
+  "lex",
+  "expression",
+  "jump",
+  "output"
+};
+
+/* Samples taken outside of any line, by phase. */
+static unsigned long loose[S_PHASES];
+
+/* Samples taken per line, by phase; see sample_lines. */
+static unsigned long *volatile counts = NULL;
+
+/* The amount of lines counts has room for. */
+static volatile sig_atomic_t lines = 0;
+
+/******************************************************************************/
+
+#ifdef VVTBI_POSIX
+
+/**
+ * tick
+ *
+ * @param signal SIGPROF.
+ * @return void
+ */
+
+static void tick (int signal)
+{
+  long line, phase;
+  (void) signal;
+  line  = sample_line;
+  phase = sample_phase;
+  if (phase < 0 || phase >= S_PHASES)
+    phase = S_STATEMENT;
+  if (line >= 0 && line < lines)
+    counts[line * S_PHASES + phase]++;
+  else
+    loose[phase]++;
+}
+
+#endif
+
+/**
+ * sample_start
+ *
+ * @param void
+ * @return Did the sampling timer start? Never, without POSIX.
+ */
+
+int sample_start (void)
+{
+#ifdef VVTBI_POSIX
+  struct sigaction action;
+  struct itimerval timer;
+
+  memset(loose, 0, sizeof loose);
+  memset(&action, 0, sizeof action);
+  action.sa_handler = tick;
+  action.sa_flags   = SA_RESTART;
+  sigemptyset(&action.sa_mask);
+  if (sigaction(SIGPROF, &action, NULL))
+    return 0;
+  /* Sample every VVTBI_SAMPLE_INTERVAL microseconds of CPU time. */
+  timer.it_interval.tv_sec  = 0;
+  timer.it_interval.tv_usec = VVTBI_SAMPLE_INTERVAL;
+  timer.it_value            = timer.it_interval;
+  return !setitimer(ITIMER_PROF, &timer, NULL);
+#else
+  return 0;
+#endif
+}
+
+/**
+ * sample_lines
+ *
+ * @param n The amount of lines in the program being sampled.
+ * @return void
+ */
+
+void sample_lines (size_t n)
+{
+  unsigned long *c;
+  c = calloc(n * S_PHASES + 1, sizeof *c);
+  if (!c)
+    return;
+  /* Publish the counts before their size, for the handler. */
+  counts = c;
+  lines  = (sig_atomic_t) n;
+}
+
+/**
+ * sample_stop
+ *
+ * @param void
+ * @return void
+ */
+
+void sample_stop (void)
+{
+#ifdef VVTBI_POSIX
+  struct itimerval timer;
+  memset(&timer, 0, sizeof timer);
+  setitimer(ITIMER_PROF, &timer, NULL);
+  signal(SIGPROF, SIG_IGN);
+#endif
+}
+
+/**
+ * sample_write
+ *
+ * @param p The program sampled.
+ * @param file The file to write folded stacks to.
+ * @return Were the samples written?
+ */
+
+int sample_write (const struct program *p, const char *file)
+{
+  FILE  *handle;
+  size_t i, j;
+  int    ok;
+
+  if (!(handle = fopen(file, "w")))
+  {
+    fprintf(stderr,
+      "*sample.c: file `%s' failed!\n",
+      file);
+    return 0;
+  }
+  /* One folded stack per line and phase: vvtbi;file;line;phase n */
+  for (j = 0; j < S_PHASES; j++)
+    if (loose[j])
+      fprintf(handle, "vvtbi;%s;%s %lu\n",
+        p->file, phase_strings[j], loose[j]);
+  for (i = 0; i < (size_t) lines && i < p->lines_count; i++)
+    for (j = 0; j < S_PHASES; j++)
+      if (counts[i * S_PHASES + j])
+        fprintf(handle, "vvtbi;%s;line_%d;%s %lu\n",
+          p->file, p->lines[i].number, phase_strings[j],
+          counts[i * S_PHASES + j]);
+  ok = !ferror(handle);
+  fclose(handle);
+  return ok;
+}
\ No newline at end of file
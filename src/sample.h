@@ -0,0 +1,35 @@
+/************************************
+   sample.h, @format.new-line  lf
+             @format.use-tabs  false
+   @format.tab-size    2
+   @format.indent-size 2
+   @format.line-length 80
+*************************************/
+#ifndef _SAMPLE_H__
+#define _SAMPLE_H__
+
+#include <signal.h>
+
+#include "program.h"
+
+/* The interpreter's phases, as sampled. */
+enum {
+  S_STATEMENT,
+  S_LEX,
+  S_EXPRESSION,
+  S_JUMP,
+  S_OUTPUT,
+  S_PHASES
+};
+
+/* The current phase and line index; the interpreter keeps
+   these up to date whether or not it is being sampled. */
+extern volatile sig_atomic_t sample_phase;
+extern volatile sig_atomic_t sample_line;
+
+int  sample_start (void);
+void sample_lines (size_t n);
+void sample_stop  (void);
+int  sample_write (const struct program *p, const char *file);
+
+#endif /* _SAMPLE_H__ */
\ No newline at end of file
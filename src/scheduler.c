@@ -0,0 +1,114 @@
+/***************************************
+   scheduler.c, @format.new-line  lf
+                @format.use-tabs  false
+   @format.tab-size    2
+   @format.indent-size 2
+   @format.line-length 80
+****************************************/
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "config.h"
+#include "scheduler.h"
+
+/******************************************************************************/
+
+/**
+ * scheduler_init
+ *
+ * @param s The scheduler to initialize.
+ * @return void
+ */
+
+void scheduler_init (struct scheduler *s)
+{
+  s->tasks   = NULL;
+  s->count   = 0;
+  s->size    = 0;
+  s->running = 0;
+}
+
+/**
+ * scheduler_add
+ *
+ * @param s The scheduler.
+ * @param source Source code file.
+ * @param budget Line-statements the script may run per turn.
+ * @return void
+ */
+
+void scheduler_add (struct scheduler *s, const char *source, int budget)
+{
+  struct scheduler_task *task;
+  /* Out of room, double the task container. */
+  if (s->count == s->size)
+  {
+    s->size  = s->size ? s->size * 2 : 8;
+    s->tasks = realloc(s->tasks, s->size * sizeof *s->tasks);
+    if (!s->tasks)
+    {
+      fprintf(stderr,
+        "*scheduler.c: out of memory!\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  task           = &s->tasks[s->count++];
+  task->budget   = budget > 0 ? budget : VVTBI_SCHEDULER_BUDGET;
+  task->executed = 0;
+  vvtbi_context(&task->ctx, source);
+  s->running++;
+}
+
+/**
+ * scheduler_tick
+ *
+ * @param s The scheduler.
+ * @return running The amount of scripts yet to finish.
+ */
+
+int scheduler_tick (struct scheduler *s)
+{
+  size_t                 i;
+  struct scheduler_task *task;
+  /* Give every unfinished script one turn of its budget. */
+  for (i = 0; i < s->count; i++)
+  {
+    task = &s->tasks[i];
+    if (task->ctx.finished)
+      continue;
+    task->executed += vvtbi_step(&task->ctx, task->budget);
+    if (task->ctx.finished)
+      s->running--;
+  }
+  return s->running;
+}
+
+/**
+ * scheduler_run
+ *
+ * @param s The scheduler.
+ * @return void
+ */
+
+void scheduler_run (struct scheduler *s)
+{
+  while (scheduler_tick(s))
+    ;
+}
+
+/**
+ * scheduler_free
+ *
+ * @param s The scheduler.
+ * @return void
+ */
+
+void scheduler_free (struct scheduler *s)
+{
+  size_t i;
+  for (i = 0; i < s->count; i++)
+    vvtbi_release(&s->tasks[i].ctx);
+  free(s->tasks);
+  scheduler_init(s);
+}
\ No newline at end of file
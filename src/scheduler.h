@@ -0,0 +1,34 @@
+/***************************************
+   scheduler.h, @format.new-line  lf
+                @format.use-tabs  false
+   @format.tab-size    2
+   @format.indent-size 2
+   @format.line-length 80
+****************************************/
+#ifndef _SCHEDULER_H__
+#define _SCHEDULER_H__
+
+#include "vvtbi.h"
+
+/* A script and its share of the scheduler. */
+struct scheduler_task {
+  struct vvtbi_context ctx;
+  int                  budget;
+  unsigned long        executed;
+};
+
+/* Round-robin over many interpreters on one thread. */
+struct scheduler {
+  struct scheduler_task *tasks;
+  size_t                 count;
+  size_t                 size;
+  size_t                 running;
+};
+
+void scheduler_init (struct scheduler *s);
+void scheduler_add  (struct scheduler *s, const char *source, int budget);
+int  scheduler_tick (struct scheduler *s);
+void scheduler_run  (struct scheduler *s);
+void scheduler_free (struct scheduler *s);
+
+#endif /* _SCHEDULER_H__ */
\ No newline at end of file
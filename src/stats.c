@@ -0,0 +1,146 @@
+/***********************************
+   stats.c, @format.new-line  lf
+            @format.use-tabs  false
+   @format.tab-size    2
+   @format.indent-size 2
+   @format.line-length 80
+************************************/
+/* getrusage is POSIX, not ANSI. */
+#ifdef VVTBI_POSIX
+#define _XOPEN_SOURCE 500
+#endif
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef VVTBI_POSIX
+#include <sys/resource.h>
+#endif
+
+#include "stats.h"
+#include "vvtbi.h"
+
+struct stats stats;
+
+/******************************************************************************/
+
+/**
+ * peak_rss
+ *
+ * @param void
+ * @return The peak resident set size, in kilobytes, or -1 if
+ *         unknown, as without POSIX.
+ */
+
+static long peak_rss (void)
+{
+#ifdef VVTBI_POSIX
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage))
+    return -1;
+  return usage.ru_maxrss;
+#else
+  return -1;
+#endif
+}
+
+/**
+ * seconds
+ *
+ * @param ticks Processor time.
+ * @return Processor time in seconds.
+ */
+
+static double seconds (clock_t ticks)
+{
+  return (double) ticks / CLOCKS_PER_SEC;
+}
+
+/**
+ * divisions
+ *
+ * @param void
+ * @return void
+ */
+
+static void divisions (void)
+{
+  struct program *p;
+  size_t          i;
+
+  /* Counted from the program run, as its proofs are redone
+     on every edit and widening. */
+  stats.divisions = stats.divisions_proven = 0;
+  if (!(p = vvtbi_program()))
+    return;
+  for (i = 0; i < p->count; i++)
+    if (p->tokens[i].token == T_SLASH)
+    {
+      stats.divisions++;
+      if (p->tokens[i].flags & PROGRAM_NONZERO)
+        stats.divisions_proven++;
+    }
+}
+
+/**
+ * stats_write
+ *
+ * @param out The stream to report to.
+ * @param json Report as a JSON object, rather than text?
+ * @return void
+ */
+
+void stats_write (FILE *out, int json)
+{
+  int         i;
+  const char *comma;
+
+  divisions();
+  if (json)
+  {
+    fprintf(out, "{\"characters\":%lu,\"tokens\":{", stats.characters);
+    for (i = T_ERROR, comma = ""; i < T_TOKENS; i++)
+      if (stats.tokens[i])
+      {
+        fprintf(out, "%s\"%s\":%lu", comma,
+          vvtbi_token(i), stats.tokens[i]);
+        comma = ",";
+      }
+    fprintf(out, "},\"statements\":{");
+    for (i = T_ERROR, comma = ""; i < T_TOKENS; i++)
+      if (stats.statements[i])
+      {
+        fprintf(out, "%s\"%s\":%lu", comma,
+          vvtbi_token(i), stats.statements[i]);
+        comma = ",";
+      }
+    fprintf(out, "},\"jumps\":%lu,\"scanned\":%lu,\"printed\":%lu,"
+      "\"peak_rss_kb\":%ld,\"allocations\":%lu,"
+      "\"divisions\":%lu,\"divisions_proven\":%lu,"
+      "\"load_seconds\":%.6f,\"run_seconds\":%.6f}\n",
+      stats.jumps, stats.scanned, stats.printed,
+      peak_rss(), stats.allocations,
+      stats.divisions, stats.divisions_proven,
+      seconds(stats.load), seconds(stats.run));
+    return;
+  }
+  fprintf(out, "characters   %lu\n", stats.characters);
+  for (i = T_ERROR; i < T_TOKENS; i++)
+    if (stats.tokens[i])
+      fprintf(out, "token        %-14s %lu\n",
+        vvtbi_token(i), stats.tokens[i]);
+  for (i = T_ERROR; i < T_TOKENS; i++)
+    if (stats.statements[i])
+      fprintf(out, "statement    %-14s %lu\n",
+        vvtbi_token(i), stats.statements[i]);
+  fprintf(out, "jumps        %lu\n", stats.jumps);
+  fprintf(out, "scanned      %lu bytes\n", stats.scanned);
+  fprintf(out, "printed      %lu bytes\n", stats.printed);
+  fprintf(out, "peak rss     %ld kB\n", peak_rss());
+  fprintf(out, "allocations  %lu\n", stats.allocations);
+  fprintf(out, "divisions    %lu, %lu unchecked\n",
+    stats.divisions, stats.divisions_proven);
+  fprintf(out, "load         %.6f s\n", seconds(stats.load));
+  fprintf(out, "run          %.6f s\n", seconds(stats.run));
+}
\ No newline at end of file
@@ -0,0 +1,34 @@
+/***********************************
+   stats.h, @format.new-line  lf
+            @format.use-tabs  false
+   @format.tab-size    2
+   @format.indent-size 2
+   @format.line-length 80
+************************************/
+#ifndef _STATS_H__
+#define _STATS_H__
+
+#include <time.h>
+
+#include "tokenizer.h"
+
+/* Run statistics, counted whether or not they are reported. */
+struct stats {
+  unsigned long characters;
+  unsigned long tokens[T_TOKENS];
+  unsigned long statements[T_TOKENS];
+  unsigned long jumps;
+  unsigned long scanned;
+  unsigned long printed;
+  unsigned long allocations;
+  unsigned long divisions;
+  unsigned long divisions_proven;
+  clock_t       load;
+  clock_t       run;
+};
+
+extern struct stats stats;
+
+void stats_write (FILE *out, int json);
+
+#endif /* _STATS_H__ */
\ No newline at end of file
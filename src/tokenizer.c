@@ -17,11 +17,14 @@
 /* The last token scanned. */
 static int token;
 
+/* The offset of the last token scanned. */
+static long offset;
+
 /* The scanner's data "pointer." */
-union Pointer {
+static union Pointer {
   char string[VVTBI_STRING_LITERAL+1];
   int  number;
-  int  letter;
+  long wide;
 } text;
 
 struct keyword_token {
@@ -37,6 +40,19 @@ static const struct keyword_token keywords[] = {
   {"print", T_PRINT},
   {"rem",   T_REM},
   {"goto",  T_GOTO},
+  {"for",   T_FOR},
+  {"to",    T_TO},
+  {"step",  T_STEP},
+  {"next",  T_NEXT},
+  {"gosub", T_GOSUB},
+  {"return",T_RETURN},
+  {"dim",   T_DIM},
+  {"call",  T_CALL},
+  {"include",T_INCLUDE},
+  {"chain", T_CHAIN},
+  {"input", T_INPUT},
+  {"read",  T_READ},
+  {"data",  T_DATA},
   {NULL,    T_ERROR}
 };
 
@@ -54,7 +70,24 @@ static int get_next_token (void);
 void tokenizer_init (const char *source)
 {
   io_init(source);
-  token = get_next_token();
+  offset = io_location();
+  token  = get_next_token();
+}
+
+/**
+ * tokenizer_buffer
+ *
+ * @param name The name of the source code.
+ * @param source The source code, already in memory.
+ * @param n The length of the source code.
+ * @return void
+ */
+
+void tokenizer_buffer (const char *name, const char *source, size_t n)
+{
+  io_buffer(name, source, n);
+  offset = io_location();
+  token  = get_next_token();
 }
 
 /**
@@ -170,9 +203,10 @@ static int token_string (void)
   while (io_current() != '"' &&
   io_current() != EOF)
   {
-    if (i >= VVTBI_STRING_LITERAL)
-      break;
-    text.string[i++] = io_current();
+    /* Truncate the string, rather than scan the rest
+       of it as tokens. */
+    if (i < VVTBI_STRING_LITERAL)
+      text.string[i++] = io_current();
     io_next();
   }
   /* Skip proceeding ". */
@@ -193,65 +227,86 @@ static int token_string (void)
 static int token_keyword (void)
 {
   size_t                      i;
-  int                         token;
+  long                        start;
   struct keyword_token const *kt;
 
-  for (i = 0, token = 0, kt = keywords; kt->keyword; kt++)
+  start = io_location();
+  for (kt = keywords; kt->keyword; kt++)
   {
-    /* A character in the stream matched a keyword character. */
-    while (toupper(kt->keyword[i]) == io_current())
-    {
-      /* We pre-increment to check the next character, and if we've
-         encountered the null-terminator, we have a match! */
-      if (!(kt->keyword[++i]))
-      {
-        if (kt->token == T_REM)
-        {
-          /* For the particular REM keyword, skip all characters
-             until EOL. */
-          while(io_current() != '\r'
-          && io_current() != '\n'
-          && io_current() != EOF)
-            io_next();
-          token = T_REM;
-          break;
-        }
-        /* Finished! Return token! */
-        io_next();
-        token = kt->token; break;
-      }
+    /* Match each keyword from the start; keywords may share
+       a prefix, as THEN and TO do. */
+    for (i = 0; kt->keyword[i] &&
+    toupper(kt->keyword[i]) == io_current(); i++)
       io_next();
+    /* If we've encountered the null-terminator, we have a match! */
+    if (!kt->keyword[i])
+    {
+      /* For the particular REM keyword, skip all characters
+         until EOL. */
+      if (kt->token == T_REM)
+        io_skip_line();
+      return kt->token;
     }
+    if (i)
+      io_seek(start, SEEK_SET);
   }
-  return token;
+  return 0;
 }
 
 /**
  * token_number
  *
  * @param void
- * @return token A [whole] number token.
+ * @return token A number token: [whole], 64-bit or decimal.
  */
 
 static int token_number (void)
 {
-  size_t i;
-  char   string[VVTBI_NUMBER_LITERAL+1];
+  size_t i, j, digits;
+  long   number;
 
-  for (i = 0; i <= VVTBI_NUMBER_LITERAL; i++)
+  /* T_WIDE and T_DECIMAL keep their digits in a long, which
+     may be only 32-bit. */
+  digits = sizeof (long) >= 8 ? VVTBI_WIDE_LITERAL : VVTBI_NARROW_LITERAL;
+  for (i = 0, number = 0; isdigit(io_current()); i++)
   {
-    /* Stream no longer a number, we've finished. */
-    if (!isdigit(io_current()))
+    /* The number exceeds the digits a long keeps. */
+    if (i == digits)
+      return T_ERROR;
+    /* Digits are contiguous in every character set. */
+    number = number * 10 + (io_current() - '0');
+    io_next();
+  }
+  /* A decimal: the digits after the point are scaled in,
+     the whole part must leave room for them. */
+  if (io_current() == '.')
+  {
+    /* Check before scaling, so the number never overflows. */
+    if (i + VVTBI_DECIMAL_DIGITS > digits)
+      return T_ERROR;
+    io_next();
+    for (j = 0; j < VVTBI_DECIMAL_DIGITS; j++)
     {
-      string[i]   = 0;
-      text.number = strtol(string, NULL, 10);
-      return T_NUMBER;
+      number *= 10;
+      if (isdigit(io_current()))
+      {
+        number += io_current() - '0';
+        io_next();
+      }
     }
-    string[i] = io_current();
-    io_next();
+    if (isdigit(io_current()))
+      return T_ERROR;
+    text.wide = number;
+    return T_DECIMAL;
   }
-  /* The number exceeds VVTBI_NUMBER_LITERAL. */
-  return T_ERROR;
+  /* Numbers too long for an int are 64-bit. */
+  if (i > VVTBI_NUMBER_LITERAL)
+  {
+    text.wide = number;
+    return T_WIDE;
+  }
+  text.number = (int) number;
+  return T_NUMBER;
 }
 
 /**
@@ -286,6 +341,29 @@ static int token_eol (int c)
   return 0;
 }
 
+/**
+ * token_name
+ *
+ * @param void
+ * @return token The variable token, or T_ERROR if too long.
+ */
+
+static int token_name (void)
+{
+  size_t i;
+  /* A lower-case letter, then lower-case letters, digits
+     and underscores. */
+  for (i = 0; islower(io_current()) || isdigit(io_current()) ||
+  io_current() == '_'; i++)
+  {
+    if (i < VVTBI_NAME_LENGTH)
+      text.string[i] = io_current();
+    io_next();
+  }
+  text.string[i < VVTBI_NAME_LENGTH ? i : VVTBI_NAME_LENGTH] = 0;
+  return i > VVTBI_NAME_LENGTH ? T_ERROR : T_LETTER;
+}
+
 /**
  * get_next_token
  *
@@ -323,10 +401,14 @@ static int get_next_token (void)
   if (token)
     return token;
 
-  /* A keyword token. */
-  token = token_keyword();
-  if (token)
-    return token;
+  /* A keyword token. Keywords are upper-case, so nothing
+     else need be matched against the keyword table. */
+  if (isupper(c))
+  {
+    token = token_keyword();
+    if (token)
+      return token;
+  }
 
   /* The string token. */
   if (c == '"')
@@ -338,11 +420,7 @@ static int get_next_token (void)
 
   /* The letter (variable) token. */
   if (isalnum(c) && islower(c))
-  {
-    text.letter = c;
-    io_next();
-    return T_LETTER;
-  }
+    return token_name();
 
   io_next();
 
@@ -365,7 +443,20 @@ void tokenizer_next (void)
   while (io_current() == ' ' ||
   io_current() == '\t')
     io_next();
-  token = get_next_token();
+  offset = io_location();
+  token  = get_next_token();
+}
+
+/**
+ * tokenizer_offset
+ *
+ * @param void
+ * @return offset The source offset of the last token scanned.
+ */
+
+long tokenizer_offset (void)
+{
+  return offset;
 }
 
 /**
@@ -405,47 +496,27 @@ int tokenizer_num (void)
 }
 
 /**
- * tokenizer_variable_num
+ * tokenizer_wide
  *
  * @param void
- * @return A variable's corresponding cell location.
+ * @return text.wide The 64-bit or decimal number, scaled.
  */
 
-int tokenizer_variable_num (void)
+long tokenizer_wide (void)
 {
-  /* This method will be used over text.letter - 'a'
-     to prevent non-portable, ASCII-only, code. */
-  switch (text.letter)
-  {
-    case 'a': return 0;
-    case 'b': return 1;
-    case 'c': return 2;
-    case 'd': return 3;
-    case 'e': return 4;
-    case 'f': return 5;
-    case 'g': return 6;
-    case 'h': return 7;
-    case 'i': return 8;
-    case 'j': return 9;
-    case 'k': return 10;
-    case 'l': return 11;
-    case 'm': return 12;
-    case 'n': return 13;
-    case 'o': return 14;
-    case 'p': return 15;
-    case 'q': return 16;
-    case 'r': return 17;
-    case 's': return 18;
-    case 't': return 19;
-    case 'u': return 20;
-    case 'v': return 21;
-    case 'w': return 22;
-    case 'x': return 23;
-    case 'y': return 24;
-    case 'z': return 25;
-  }
-  /* Should not reach here. */
-  return 0;
+  return text.wide;
+}
+
+/**
+ * tokenizer_name
+ *
+ * @param void
+ * @return text.string The pointer to the variable's name.
+ */
+
+char *tokenizer_name (void)
+{
+  return text.string;
 }
 
 /**
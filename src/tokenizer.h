@@ -34,16 +34,40 @@ enum {
   T_GOTO,
   T_LEFT_PAREN,
   T_RIGHT_PAREN,
-  T_EOL
+  T_EOL,
+
+  T_FOR,
+  T_TO,
+  T_STEP,
+  T_NEXT,
+  T_GOSUB,
+  T_RETURN,
+  T_DIM,
+  T_WIDE,
+  T_DECIMAL,
+  T_CALL,
+  T_FUNCTION,
+  T_INCLUDE,
+  T_CHAIN,
+  T_INPUT,
+  T_READ,
+  T_DATA,
+
+  /* One past the last token. */
+  T_TOKENS
 };
 
 void  tokenizer_init         (const char *source);
+void  tokenizer_buffer       (const char *name, const char *source,
+                              size_t n);
 int   tokenizer_finished     (void);
-int   tokenizer_variable_num (void);
+char *tokenizer_name         (void);
 char *tokenizer_string       (void);
 int   tokenizer_num          (void);
+long  tokenizer_wide         (void);
 void  reset                  (int to);
 int   tokenizer_token        (void);
 void  tokenizer_next         (void);
+long  tokenizer_offset       (void);
 
 #endif /* _TOKENIZER_H__ */
\ No newline at end of file
@@ -0,0 +1,280 @@
+/***********************************
+   trace.c, @format.new-line  lf
+            @format.use-tabs  false
+   @format.tab-size    2
+   @format.indent-size 2
+   @format.line-length 80
+************************************/
+/* clock_gettime and SIGUSR1 are POSIX, not ANSI. */
+#ifdef VVTBI_POSIX
+#define _XOPEN_SOURCE 500
+#define _POSIX_C_SOURCE 199309L
+#endif
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <time.h>
+
+#include "config.h"
+#include "trace.h"
+#include "vvtbi.h"
+
+int tracing = 0;
+
+/* The ring of the last VVTBI_TRACE_SIZE line-statements. */
+static struct trace_entry ring[VVTBI_TRACE_SIZE];
+
+/* The amount of entries ever written; the next is at its remainder. */
+static unsigned long head = 0;
+
+/* The file dumps are written to. */
+static const char *trace_file = NULL;
+
+/* When tracing began: without POSIX, in processor time. */
+#ifdef VVTBI_POSIX
+static struct timespec began;
+#else
+static clock_t began;
+#endif
+
+/* Has SIGUSR1 asked for a dump? */
+static volatile sig_atomic_t requested = 0;
+
+/******************************************************************************/
+
+#ifdef VVTBI_POSIX
+
+/**
+ * request
+ *
+ * @param signal SIGUSR1.
+ * @return void
+ */
+
+static void request (int signal)
+{
+  (void) signal;
+  /* The dump happens at the next line-statement, not in here. */
+  requested = 1;
+}
+
+#endif
+
+/**
+ * elapsed
+ *
+ * @param void
+ * @return The nanoseconds since tracing began.
+ */
+
+static unsigned long elapsed (void)
+{
+#ifdef VVTBI_POSIX
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (unsigned long) (now.tv_sec - began.tv_sec) * 1000000000UL +
+    now.tv_nsec - began.tv_nsec;
+#else
+  return (unsigned long) ((double) (clock() - began) / CLOCKS_PER_SEC *
+    1e9);
+#endif
+}
+
+/**
+ * trace_exit
+ *
+ * @param void
+ * @return void
+ */
+
+static void trace_exit (void)
+{
+  if (tracing)
+    trace_dump();
+}
+
+/**
+ * trace_start
+ *
+ * @param file The file to dump the trace to.
+ * @return Did tracing start?
+ */
+
+int trace_start (const char *file)
+{
+  trace_file = file;
+  head       = 0;
+#ifdef VVTBI_POSIX
+  clock_gettime(CLOCK_MONOTONIC, &began);
+#else
+  began      = clock();
+#endif
+  /* Dump at exit, which includes every E_ERROR. */
+  if (atexit(trace_exit))
+    return 0;
+#ifdef VVTBI_POSIX
+  signal(SIGUSR1, request);
+#endif
+  tracing = 1;
+  return 1;
+}
+
+/**
+ * trace_line
+ *
+ * @param line The line number about to run, or -1.
+ * @param kind The line-statement's first token.
+ * @return void
+ */
+
+void trace_line (int line, int kind)
+{
+  struct trace_entry *e;
+
+  if (requested)
+  {
+    requested = 0;
+    trace_dump();
+  }
+  e           = &ring[head++ & (VVTBI_TRACE_SIZE - 1)];
+  e->time     = elapsed();
+  e->line     = line;
+  e->kind     = kind;
+  e->variable = -1;
+  e->value    = 0;
+}
+
+/**
+ * trace_variable
+ *
+ * @param variable The slot of the variable the line-statement set.
+ * @param value The value it set.
+ * @return void
+ */
+
+void trace_variable (int variable, int value)
+{
+  struct trace_entry *e;
+  if (!head)
+    return;
+  e           = &ring[(head - 1) & (VVTBI_TRACE_SIZE - 1)];
+  e->variable = variable;
+  e->value    = value;
+}
+
+/**
+ * trace_dump
+ *
+ * @param void
+ * @return void
+ */
+
+void trace_dump (void)
+{
+  FILE           *handle;
+  struct program *p;
+  unsigned long   count, first, header[4];
+  size_t          i;
+
+  if (!(handle = fopen(trace_file, "wb")))
+  {
+    fprintf(stderr,
+      "*trace.c: file `%s' failed!\n",
+      trace_file);
+    return;
+  }
+  count     = head < VVTBI_TRACE_SIZE ? head : VVTBI_TRACE_SIZE;
+  first     = head - count;
+  header[0] = VVTBI_TRACE_VERSION;
+  header[1] = sizeof *ring;
+  header[2] = count;
+  header[3] = 0;
+  /* The variables' names, by slot, each ending in NUL. */
+  p = vvtbi_program();
+  for (i = 0; p && i < p->variable_count; i++)
+    header[3] += strlen(program_name(p, (int) i)) + 1;
+  fwrite(VVTBI_TRACE_MAGIC, 1, 4, handle);
+  fwrite(header, sizeof header, 1, handle);
+  for (i = 0; p && i < p->variable_count; i++)
+    fwrite(program_name(p, (int) i), 1,
+      strlen(program_name(p, (int) i)) + 1, handle);
+  /* Oldest first: the ring from the oldest entry, then its start. */
+  first &= VVTBI_TRACE_SIZE - 1;
+  if (first + count > VVTBI_TRACE_SIZE)
+  {
+    fwrite(ring + first, sizeof *ring, VVTBI_TRACE_SIZE - first, handle);
+    fwrite(ring, sizeof *ring, first + count - VVTBI_TRACE_SIZE, handle);
+  }
+  else
+    fwrite(ring + first, sizeof *ring, count, handle);
+  fclose(handle);
+}
+
+/**
+ * trace_decode
+ *
+ * @param file The trace file to decode.
+ * @param out The stream to print the trace to.
+ * @return Was the trace decoded?
+ */
+
+int trace_decode (const char *file, FILE *out)
+{
+  FILE              *handle;
+  char               magic[4], *names, **name;
+  unsigned long      header[4], i, n;
+  struct trace_entry e;
+
+  if (!(handle = fopen(file, "rb")))
+  {
+    fprintf(stderr,
+      "*trace.c: file `%s' failed!\n",
+      file);
+    return 0;
+  }
+  /* The trace is raw entries; it must come from this build. */
+  if (fread(magic, 1, 4, handle) != 4 ||
+  memcmp(magic, VVTBI_TRACE_MAGIC, 4) ||
+  fread(header, sizeof header, 1, handle) != 1 ||
+  header[0] != VVTBI_TRACE_VERSION ||
+  header[1] != sizeof e)
+  {
+    fprintf(stderr, "*trace.c: `%s' is not a trace\n", file);
+    fclose(handle);
+    return 0;
+  }
+  /* The names, and a pointer to each by slot. */
+  names = malloc(header[3] + 1);
+  name  = malloc((header[3] + 1) * sizeof *name);
+  if (!names || !name || fread(names, 1, header[3], handle) != header[3])
+  {
+    fprintf(stderr, "*trace.c: `%s' is not a trace\n", file);
+    free(names);
+    free(name);
+    fclose(handle);
+    return 0;
+  }
+  names[header[3]] = 0;
+  for (i = 0, n = 0; i < header[3]; i += strlen(names + i) + 1)
+    name[n++] = names + i;
+  fprintf(out, "%8s %16s %8s %-12s %s\n",
+    "#", "ns", "line", "statement", "variable");
+  for (i = 0; i < header[2] && fread(&e, sizeof e, 1, handle); i++)
+  {
+    fprintf(out, "%8lu %16lu ", i, e.time);
+    if (e.line >= 0)
+      fprintf(out, "%8d ", e.line);
+    else
+      fprintf(out, "%8s ", "-");
+    fprintf(out, "%-12s", vvtbi_token(e.kind));
+    if (e.variable >= 0 && (unsigned long) e.variable < n)
+      fprintf(out, " %s = %d", name[e.variable], e.value);
+    fprintf(out, "\n");
+  }
+  free(names);
+  free(name);
+  fclose(handle);
+  return 1;
+}
\ No newline at end of file
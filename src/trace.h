@@ -0,0 +1,33 @@
+/***********************************
+   trace.h, @format.new-line  lf
+            @format.use-tabs  false
+   @format.tab-size    2
+   @format.indent-size 2
+   @format.line-length 80
+************************************/
+#ifndef _TRACE_H__
+#define _TRACE_H__
+
+/* The trace file format, see trace_dump. */
+#define VVTBI_TRACE_MAGIC   "VVTR"
+#define VVTBI_TRACE_VERSION 2
+
+/* An executed line-statement. */
+struct trace_entry {
+  unsigned long time;
+  int           line;
+  int           kind;
+  int           variable;
+  int           value;
+};
+
+/* Is the trace being written? Checked before each line-statement. */
+extern int tracing;
+
+int  trace_start    (const char *file);
+void trace_line     (int line, int kind);
+void trace_variable (int variable, int value);
+void trace_dump     (void);
+int  trace_decode   (const char *file, FILE *out);
+
+#endif /* _TRACE_H__ */
\ No newline at end of file
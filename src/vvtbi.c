@@ -12,8 +12,13 @@
 #include <ctype.h>
 
 #include "config.h"
-#include "io.h"
 #include "tokenizer.h"
+#include "program.h"
+#include "sample.h"
+#include "stats.h"
+#include "trace.h"
+#include "output.h"
+#include "input.h"
 #include "vvtbi.h"
 
 /* Token strings. */
@@ -45,7 +50,24 @@ static const char *token_strings[] =
   "T_GOTO",
   "T_LEFT_PAREN",
   "T_RIGHT_PAREN",
-  "T_EOL"
+  "T_EOL",
+
+  "T_FOR",
+  "T_TO",
+  "T_STEP",
+  "T_NEXT",
+  "T_GOSUB",
+  "T_RETURN",
+  "T_DIM",
+  "T_WIDE",
+  "T_DECIMAL",
+  "T_CALL",
+  "T_FUNCTION",
+  "T_INCLUDE",
+  "T_CHAIN",
+  "T_INPUT",
+  "T_READ",
+  "T_DATA"
 };
 
 /* Debugging error constants. */
@@ -53,13 +75,85 @@ enum {
   E_ERROR = 1, E_WARNING
 };
 
-/* The variable container. (a - z) */
-#define VVTBI_VARIABLES 26
-static int variables[26];
+/* A typed value: its type and number, decimals scaled by
+   VVTBI_DECIMAL_SCALE. Only expressions not int, found at
+   load, are evaluated on these. */
+struct value {
+  int  type;
+  long number;
+};
+
+/* The variable container of the running program, by slot. */
+static int    *variables      = NULL;
+static size_t  variable_count = 0;
+
+/* The wide and decimal variables of the running program, by
+   slot; an int variable's place is unused. */
+static long *wides = NULL;
+
+/* The variables of the program loaded by vvtbi_init. */
+static int  *loaded_variables = NULL;
+static long *loaded_wides     = NULL;
+
+/* The arrays of the running program, see DIM. */
+static int *arena = NULL;
+
+/* The memory holding the arrays of the program loaded by
+   vvtbi_init. */
+static void *arena_block = NULL;
+
+/* The running program, see vvtbi_init and vvtbi_step. */
+static struct program *program = NULL;
+
+/* The program loaded by vvtbi_init. */
+static struct program *loaded  = NULL;
+
+/* The FOR loops running, innermost last. */
+static struct vvtbi_loop loops[VVTBI_LOOPS];
+static int               loop_count = 0;
+
+/* The tokens GOSUBs return to, innermost last. */
+static size_t returns[VVTBI_RETURNS];
+static int    return_count = 0;
+
+/* The index of the DATA item READ takes next. */
+static size_t data = 0;
+
+/* The running context, if run by vvtbi_step, and the hosts
+   of its program's functions, see vvtbi_register. */
+static struct vvtbi_context     *context    = NULL;
+static const struct vvtbi_host **calls      = NULL;
+static size_t                    call_count = 0;
+
+/* May what the program was proven at load go unchecked? See
+   vvtbi_restore. */
+static int proofs = 1;
+
+/* The index of the current token in the running program. */
+static size_t pc = 0;
+
+/* The index of the current line in the line table, or -1. */
+static int line = -1;
+
+/* The counts being recorded, see vvtbi_profile. */
+static struct profile_count *profile = NULL;
+
+/* Functions called before each line-statement, see vvtbi_hook. */
+static void (*hooks[VVTBI_HOOKS]) (int line);
+
+/* The amount of hooks. */
+static int hook_count = 0;
+
+/* The function called when CHAIN switches programs, see
+   vvtbi_chained. */
+static void (*chained) (const struct program *from,
+  const struct program *to) = NULL;
 
 static int expression (void);
+static struct value typed_expression (void);
 static void line_statement (void);
 static void statement (void);
+static void resolve (struct vvtbi_context *ctx);
 
 /******************************************************************************/
 
@@ -77,6 +171,9 @@ static void dprintf(const char *format,
 {
   va_list args;
 
+  /* What was PRINTed goes before the message, written through
+     the thread or not. */
+  output_flush();
   va_start(args, error);
   vfprintf(stderr, format, args);
   va_end(args);
@@ -85,6 +182,88 @@ static void dprintf(const char *format,
     exit(EXIT_FAILURE);
 }
 
+/**
+ * current_token
+ *
+ * @param void
+ * @return The current token in the program.
+ */
+
+static int current_token (void)
+{
+  return program->tokens[pc].token;
+}
+
+/**
+ * next_token
+ *
+ * @param void
+ * @return void
+ */
+
+static void next_token (void)
+{
+  /* The program ends with T_EOF; stay there. */
+  if (program->tokens[pc].token != T_EOF)
+    pc++;
+}
+
+/**
+ * token_num
+ *
+ * @param void
+ * @return The current token's number.
+ */
+
+static int token_num (void)
+{
+  return program->tokens[pc].value;
+}
+
+/**
+ * token_variable
+ *
+ * @param void
+ * @return The current token's variable cell location.
+ */
+
+static int token_variable (void)
+{
+  return program->tokens[pc].value;
+}
+
+/**
+ * token_string
+ *
+ * @param void
+ * @return The current token's string literal.
+ */
+
+static const char *token_string (void)
+{
+  return program->strings + program->tokens[pc].value;
+}
+
+/**
+ * near
+ *
+ * @param dest The destination to copy characters.
+ * @param n The size of dest.
+ * @return void
+ */
+
+static void near (char *dest, size_t n)
+{
+  const char *source;
+  size_t      i;
+  source = program->source + program->tokens[pc].offset;
+  /* Copy the source text at the current token, up to EOL. */
+  for (i = 0; i + 1 < n && source[i] &&
+  source[i] != '\r' && source[i] != '\n'; i++)
+    dest[i] = source[i];
+  dest[i] = 0;
+}
+
 /**
  * set_variable
  *
@@ -95,7 +274,7 @@ static void dprintf(const char *format,
 
 static void set_variable (int place, int value)
 {
-  if (place >= 0 && place <= VVTBI_VARIABLES)
+  if (place >= 0 && (size_t) place < variable_count)
     variables[place] = value;
 }
 
@@ -108,11 +287,51 @@ static void set_variable (int place, int value)
 
 static int get_variable (int place)
 {
-  if (place >= 0 && place <= VVTBI_VARIABLES)
+  if (place >= 0 && (size_t) place < variable_count)
     return variables[place];
   return 0;
 }
 
+/**
+ * allocate_cells
+ *
+ * @param cells The variables to resize.
+ * @param size The size of a variable.
+ * @param from Their amount.
+ * @param to The amount wanted; new ones are zero.
+ * @return The variables.
+ */
+
+static void *allocate_cells (void *cells, size_t size, size_t from,
+  size_t to)
+{
+  /* Never zero bytes, which may be NULL. */
+  if (!(cells = realloc(cells, (to + 1) * size)))
+    dprintf("*vvtbi.c: out of memory\n", E_ERROR);
+  if (to > from)
+    memset((char *) cells + from * size, 0, (to - from) * size);
+  return cells;
+}
+
+/**
+ * allocate_arena
+ *
+ * @param block The memory holding the arrays, to reallocate.
+ * @param size The amount of elements.
+ * @return The elements, zeroed and aligned to a cache line.
+ */
+
+static int *allocate_arena (void **block, size_t size)
+{
+  size_t misalign;
+  free(*block);
+  if (!(*block = calloc(1, size * sizeof (int) + VVTBI_ARENA_ALIGN)))
+    dprintf("*vvtbi.c: out of memory\n", E_ERROR);
+  misalign = (size_t) *block % VVTBI_ARENA_ALIGN;
+  return (int *) ((char *) *block +
+    (misalign ? VVTBI_ARENA_ALIGN - misalign : 0));
+}
+
 /**
  * vvtbi_init
  *
@@ -122,9 +341,28 @@ static int get_variable (int place)
 
 void vvtbi_init (const char *source)
 {
-  tokenizer_init(source);
+  if (loaded)
+    program_release(loaded);
+  /* Compile the source, or reuse it if cached. */
+  loaded = program = program_load(source);
+  pc     = 0;
   /* initialize the variable container. */
-  memset(variables, 0, VVTBI_VARIABLES);
+  variable_count   = program->variable_count;
+  loaded_variables = allocate_cells(loaded_variables, sizeof (int), 0,
+    variable_count);
+  loaded_wides     = allocate_cells(loaded_wides, sizeof (long), 0,
+    variable_count);
+  variables        = loaded_variables;
+  wides            = loaded_wides;
+  arena            = allocate_arena(&arena_block, program->arena_size);
+  loop_count       = 0;
+  return_count     = 0;
+  data             = 0;
+  proofs           = 1;
+  /* Nothing is registered outside a context. */
+  context          = NULL;
+  calls            = NULL;
+  call_count       = 0;
 }
 
 /**
@@ -137,7 +375,7 @@ void vvtbi_init (const char *source)
 const char *vvtbi_token (int token)
 {
   /* Boundary check. */
-  if (token < T_ERROR || token > T_EOL)
+  if (token < T_ERROR || token >= T_TOKENS)
     return "T_ERROR";
   return token_strings[token];
 }
@@ -152,19 +390,136 @@ const char *vvtbi_token (int token)
 static void accept (int token)
 {
   char string[10];
-  if (token != tokenizer_token())
+  if (token != current_token())
   {
     /* Token was unexpected. */
-    to_string(string, sizeof string);
+    near(string, sizeof string);
     dprintf("*vvtbi.c: unexpected `%s' "
       "near `%s', expected: `%s'\n",
       E_ERROR,
-      vvtbi_token(tokenizer_token()),
+      vvtbi_token(current_token()),
       /* If empty, EOF! */
       ((strlen(string)) ? string : "EOF"),
       vvtbi_token(token));
   }
-  tokenizer_next();
+  next_token();
+}
+
+/**
+ * convert
+ *
+ * @param v A typed value.
+ * @param type The type wanted: v's, or wider.
+ * @return The value's number, in that type.
+ */
+
+static long convert (struct value v, int type)
+{
+  if (type == PROGRAM_DECIMAL && v.type != PROGRAM_DECIMAL)
+    return v.number * VVTBI_DECIMAL_SCALE;
+  return v.number;
+}
+
+/**
+ * whole
+ *
+ * @param v A typed value.
+ * @return The value, less any fraction.
+ */
+
+static long whole (struct value v)
+{
+  return v.type == PROGRAM_DECIMAL ? v.number / VVTBI_DECIMAL_SCALE :
+    v.number;
+}
+
+/**
+ * element
+ *
+ * @param void
+ * @return The place in the arena of the array element at pc.
+ */
+
+static size_t element (void)
+{
+  const struct program_array *a;
+  int                         checked, index;
+  size_t                      start;
+  char                        string[10];
+  start   = pc;
+  a       = &program->arrays[token_variable()];
+  /* The index may be proven in bounds when loaded. */
+  checked = !proofs || !(program->tokens[pc].flags & PROGRAM_IN_BOUNDS);
+  accept(T_LETTER);
+  accept(T_LEFT_PAREN);
+  if (program->tokens[pc].flags & PROGRAM_TYPED)
+    index = (int) whole(typed_expression());
+  else
+    index = expression();
+  accept(T_RIGHT_PAREN);
+  if (checked && (index < 0 || (size_t) index >= a->length))
+  {
+    pc = start;
+    near(string, sizeof string);
+    dprintf("*vvtbi.c: %s %d near `%s'\n", E_ERROR,
+      a->length ? "index out of bounds:" : "array not dimensioned:",
+      index, string);
+  }
+  return a->base + (size_t) index;
+}
+
+/**
+ * call
+ *
+ * @param void
+ * @return The value of the host function CALLed at pc.
+ */
+
+static int call (void)
+{
+  const struct vvtbi_host *host;
+  int                      args[VVTBI_ARGUMENTS];
+  int                      count, function;
+  size_t                   start;
+  char                     string[10];
+
+  start    = pc;
+  accept(T_CALL);
+  function = token_variable();
+  accept(T_FUNCTION);
+  /* Resolved to its host by vvtbi_register, not by name. */
+  host     = (size_t) function < call_count ? calls[function] : NULL;
+  if (!host)
+  {
+    pc = start;
+    near(string, sizeof string);
+    dprintf("*vvtbi.c: function not registered near `%s'\n", E_ERROR,
+      string);
+  }
+  accept(T_LEFT_PAREN);
+  for (count = 0; current_token() != T_RIGHT_PAREN; count++)
+  {
+    if (count)
+      accept(T_SEPERATOR);
+    if (count == host->arity)
+    {
+      near(string, sizeof string);
+      dprintf("*vvtbi.c: `%s' takes %d arguments near `%s'\n",
+        E_ERROR, host->name, host->arity, string);
+    }
+    if (program->tokens[pc].flags & PROGRAM_TYPED)
+      args[count] = (int) whole(typed_expression());
+    else
+      args[count] = expression();
+  }
+  if (count != host->arity)
+  {
+    near(string, sizeof string);
+    dprintf("*vvtbi.c: `%s' takes %d arguments near `%s'\n",
+      E_ERROR, host->name, host->arity, string);
+  }
+  accept(T_RIGHT_PAREN);
+  return host->function(context, args);
 }
 
 /**
@@ -177,10 +532,10 @@ static void accept (int token)
 static int factor (void)
 {
   int r;
-  switch (tokenizer_token())
+  switch (current_token())
   {
     case T_NUMBER:
-      r = tokenizer_num();
+      r = token_num();
       accept(T_NUMBER);
       break;
     case T_LEFT_PAREN:
@@ -188,9 +543,17 @@ static int factor (void)
       r = expression();
       accept(T_RIGHT_PAREN);
       break;
+    case T_CALL:
+      r = call();
+      break;
     default:
+      if (program->tokens[pc + 1].token == T_LEFT_PAREN)
+      {
+        r = arena[element()];
+        break;
+      }
       r = get_variable(
-        tokenizer_variable_num());
+        token_variable());
       accept(T_LETTER);
       break;
   }
@@ -206,13 +569,15 @@ static int factor (void)
 
 static int term (void)
 {
-  int f1, f2, op;
+  int f1, f2, op, proven;
   f1 = factor();
-  op = tokenizer_token();
+  op = current_token();
   while (op == T_ASTERISK ||
   op == T_SLASH)
   {
-    tokenizer_next();
+    /* A divisor proven non-zero at load is not checked. */
+    proven = proofs && program->tokens[pc].flags & PROGRAM_NONZERO;
+    next_token();
     f2 = factor();
     switch (op)
     {
@@ -220,7 +585,7 @@ static int term (void)
         f1 = f1 * f2;
         break;
       case T_SLASH:
-        if (f2 == 0)
+        if (!proven && f2 == 0)
         {
           /* Divide by zero. */
           dprintf(
@@ -234,7 +599,7 @@ static int term (void)
         }
         break;
     }
-    op = tokenizer_token();
+    op = current_token();
   }
   return f1;
 }
@@ -248,13 +613,15 @@ static int term (void)
 
 static int expression (void)
 {
-  int t1, t2, op;
+  int t1, t2, op, phase;
+  phase        = sample_phase;
+  sample_phase = S_EXPRESSION;
   t1 = term();
-  op = tokenizer_token();
+  op = current_token();
   while(op == T_PLUS ||
   op == T_MINUS)
   {
-    tokenizer_next();
+    next_token();
     t2 = term();
     switch (op)
     {
@@ -265,8 +632,9 @@ static int expression (void)
         t1 = t1 - t2;
         break;
     }
-    op = tokenizer_token();
+    op = current_token();
   }
+  sample_phase = phase;
   return t1;
 }
 
@@ -281,7 +649,7 @@ static int relation (void)
 {
   int r1, r2, op;
   r1 = expression();
-  op = tokenizer_token();
+  op = current_token();
   while (op == T_EQUAL ||
   op == T_LT ||
   op == T_GT ||
@@ -289,7 +657,7 @@ static int relation (void)
   op == T_GT_EQ ||
   op == T_NOT_EQUAL)
   {
-    tokenizer_next();
+    next_token();
     r2 = expression();
     switch (op)
     {
@@ -312,204 +680,775 @@ static int relation (void)
         r1 = r1 != r2;
         break;
     }
-    op = tokenizer_token();
+    op = current_token();
   }
   return r1;
 }
 
 /**
- * find_linenum
+ * typed_factor
  *
- * @param linenum Line number to search and find.
- * @return void
+ * @param void
+ * @return v The typed factor.
  */
 
-static void find_linenum (int linenum)
+static struct value typed_factor (void)
 {
-  /* Skip irrelevant new-lines and comments. */
-  while (tokenizer_token() != T_NUMBER)
-    tokenizer_next();
-  while (tokenizer_num() != linenum &&
-  tokenizer_token() != T_EOF)
+  struct value v;
+  int          place;
+  switch (current_token())
   {
-    /* Check line number, then skip the rest of line statement. */
-    do {
-      do {
-        tokenizer_next();
-      } while (tokenizer_token() != T_EOL &&
-      tokenizer_token() != T_EOF);
-      if (tokenizer_token() == T_EOL)
+    case T_NUMBER:
+      v.type   = PROGRAM_INTEGER;
+      v.number = token_num();
+      next_token();
+      break;
+    case T_WIDE:
+    case T_DECIMAL:
+      v.type   = current_token() == T_WIDE ? PROGRAM_WIDE : PROGRAM_DECIMAL;
+      v.number = program->constants[program->tokens[pc].value];
+      next_token();
+      break;
+    case T_LEFT_PAREN:
+      accept(T_LEFT_PAREN);
+      v = typed_expression();
+      accept(T_RIGHT_PAREN);
+      break;
+    case T_CALL:
+      v.type   = PROGRAM_INTEGER;
+      v.number = call();
+      break;
+    default:
+      v.type = PROGRAM_INTEGER;
+      if (program->tokens[pc + 1].token == T_LEFT_PAREN)
       {
-        /* Skip irrelevant new-lines and comments. */
-        while (tokenizer_token() != T_NUMBER &&
-        tokenizer_token() != T_EOF)
-          tokenizer_next();
+        v.number = arena[element()];
+        break;
       }
-    } while (tokenizer_token() != T_NUMBER &&
-      tokenizer_token() != T_EOF);
+      place  = token_variable();
+      v.type = program->types[place];
+      accept(T_LETTER);
+      v.number = v.type == PROGRAM_INTEGER ? get_variable(place) :
+        wides[place];
+      break;
   }
+  return v;
 }
 
 /**
- * jump_linenum
+ * typed_term
  *
- * @param linenum The line number to [attempt] jump to.
- * @return void
+ * @param void
+ * @return f1 The typed term.
  */
 
-static void jump_linenum (int linenum)
+static struct value typed_term (void)
 {
-  FILE *original;
-  int   finished;
-
-  /* Not only does this verify whether the scanner finished,
-     if it has finished, it additionally closes the stream. */
-  finished = tokenizer_finished();
-  /* We save this copy in case the scanner wasn't finished. */
-  original = io_handle();
-
-  /* Start a new scanner from the beginning of the file. */
-  tokenizer_init(io_file());
-  reset(T_ERROR);
-  io_reset();
-
-  /* Search for linenum. */
-  find_linenum(linenum);
-
-  /* If the search ended at EOF, linenum could not be found! */
-  if (tokenizer_finished())
+  struct value f1, f2;
+  int          op, type, proven;
+  f1 = typed_factor();
+  op = current_token();
+  while (op == T_ASTERISK ||
+  op == T_SLASH)
   {
-    dprintf(
-      "*warning: could not jump to `%d'\n",
-      E_WARNING, linenum);
-    /* Set back to original stream */
-    io_set(io_file(), original);
-    /* Prepare scanner to continue. */
-    if (!finished)
+    proven = proofs && program->tokens[pc].flags & PROGRAM_NONZERO;
+    next_token();
+    f2 = typed_factor();
+    /* The wider of the two; decimals rescale. */
+    type      = f1.type > f2.type ? f1.type : f2.type;
+    f1.number = convert(f1, type);
+    f2.number = convert(f2, type);
+    f1.type   = type;
+    switch (op)
     {
-      reset(T_NUMBER);
-      io_reset();
-      io_next();
+      case T_ASTERISK:
+        f1.number *= f2.number;
+        if (f1.type == PROGRAM_DECIMAL)
+          f1.number /= VVTBI_DECIMAL_SCALE;
+        break;
+      case T_SLASH:
+        if (!proven && f2.number == 0)
+        {
+          /* Divide by zero. */
+          dprintf(
+            "*warning: divide by zero\n",
+            E_WARNING);
+          f1.number = 0;
+        }
+        else if (f1.type == PROGRAM_DECIMAL)
+          f1.number = f1.number * VVTBI_DECIMAL_SCALE / f2.number;
+        else
+          f1.number /= f2.number;
+        break;
     }
+    op = current_token();
   }
+  return f1;
 }
 
 /**
- * goto_statement
+ * typed_expression
  *
  * @param void
- * @return void
+ * @return t1 The typed expression.
  */
 
-static void goto_statement (void)
+static struct value typed_expression (void)
 {
-  int to;
-  accept(T_GOTO);
-  to = tokenizer_num();
-  accept(T_NUMBER);
-  accept(T_EOL);
-  jump_linenum(to);
+  struct value t1, t2;
+  int          op, type;
+  t1 = typed_term();
+  op = current_token();
+  while (op == T_PLUS ||
+  op == T_MINUS)
+  {
+    next_token();
+    t2 = typed_term();
+    type      = t1.type > t2.type ? t1.type : t2.type;
+    t1.number = convert(t1, type);
+    t2.number = convert(t2, type);
+    t1.type   = type;
+    t1.number = op == T_PLUS ? t1.number + t2.number :
+      t1.number - t2.number;
+    op = current_token();
+  }
+  return t1;
 }
 
 /**
- * print_statement
+ * typed_relation
  *
  * @param void
- * @return void
+ * @return r1 The relation of typed expressions.
  */
 
-static void print_statement (void)
+static int typed_relation (void)
 {
-  accept(T_PRINT);
-  do {
-    /* Print a string literal. */
-    if (tokenizer_token() == T_STRING)
-    {
-      printf("%s", tokenizer_string());
-      tokenizer_next();
-    }
-    /* A seperator, send a space. */
-    else if (tokenizer_token() == T_SEPERATOR)
-    {
-      printf(" ");
-      tokenizer_next();
-    }
-    /* Evaluate and print an expression. */
-    else if (tokenizer_token() == T_LETTER ||
-    tokenizer_token() == T_NUMBER ||
-    tokenizer_token() == T_LEFT_PAREN)
-      printf("%d", expression());
-    else
+  struct value r1, r2;
+  long         a, b;
+  int          op;
+  r1 = typed_expression();
+  op = current_token();
+  while (op == T_EQUAL ||
+  op == T_LT ||
+  op == T_GT ||
+  op == T_LT_EQ ||
+  op == T_GT_EQ ||
+  op == T_NOT_EQUAL)
+  {
+    next_token();
+    r2 = typed_expression();
+    a  = convert(r1, r1.type > r2.type ? r1.type : r2.type);
+    b  = convert(r2, r1.type > r2.type ? r1.type : r2.type);
+    switch (op)
     {
-      break;
+      case T_EQUAL:
+        a = a == b;
+        break;
+      case T_LT:
+        a = a < b;
+        break;
+      case T_GT:
+        a = a > b;
+        break;
+      case T_LT_EQ:
+        a = a <= b;
+        break;
+      case T_GT_EQ:
+        a = a >= b;
+        break;
+      case T_NOT_EQUAL:
+        a = a != b;
+        break;
     }
-    /* This additionally ensures a new-line character
-       is present at the end of the line-statement. */
-    if (tokenizer_finished())
-      accept(T_EOL);
-  } while (tokenizer_token() != T_EOL &&
-    tokenizer_token() != T_EOF);
+    r1.type   = PROGRAM_INTEGER;
+    r1.number = a;
+    op = current_token();
+  }
+  return r1.number != 0;
+}
+
+/**
+ * operand
+ *
+ * @param typed Is the expression to be run on typed values?
+ * @return v The expression, typed.
+ */
 
-  printf("\n");
-  tokenizer_next();
+static struct value operand (int typed)
+{
+  struct value v;
+  if (typed)
+    return typed_expression();
+  v.type   = PROGRAM_INTEGER;
+  v.number = expression();
+  return v;
 }
 
 /**
- * if_statement
+ * typed_store
  *
- * @param void
+ * @param place The variable's slot.
+ * @param v The typed value to store, in the variable's type.
  * @return void
  */
 
-static void if_statement (void)
+static void typed_store (int place, struct value v)
 {
-  int r, to;
-  accept(T_IF);
-  r = relation();
-  accept(T_THEN);
-  to = tokenizer_num();
-  accept(T_NUMBER);
-  accept(T_EOL);
-  if (r)
-    jump_linenum(to);
+  if (program->types[place] == PROGRAM_INTEGER)
+    set_variable(place, (int) whole(v));
+  else
+    wides[place] = convert(v, program->types[place]);
+  if (tracing)
+    trace_variable(place, (int) whole(v));
 }
 
 /**
- * let_statement
+ * print_value
  *
- * @param void
- * @return void
+ * @param v A typed value.
+ * @return The amount of characters printed.
  */
 
-static void let_statement (void)
+static int print_value (struct value v)
 {
-  int var;
-  var = tokenizer_variable_num();
-  accept(T_LETTER);
-  accept(T_EQUAL);
-  set_variable(var, expression());
-  accept(T_EOL);
+  char digits[VVTBI_DECIMAL_DIGITS + 2];
+  long fraction;
+  int  n;
+  if (v.type != PROGRAM_DECIMAL)
+    return output_print("%ld", v.number);
+  /* The fraction, less trailing zeros. */
+  fraction = v.number % VVTBI_DECIMAL_SCALE;
+  if (fraction < 0)
+    fraction = -fraction;
+  if (!fraction)
+    return output_print("%ld", v.number / VVTBI_DECIMAL_SCALE);
+  sprintf(digits, "%0*ld", VVTBI_DECIMAL_DIGITS, fraction);
+  for (n = VVTBI_DECIMAL_DIGITS; digits[n - 1] == '0'; n--)
+    ;
+  digits[n] = 0;
+  return output_print("%s%ld.%s", v.number < 0 &&
+    v.number > -VVTBI_DECIMAL_SCALE ? "-" : "",
+    v.number / VVTBI_DECIMAL_SCALE, digits);
 }
 
 /**
- * statement
+ * jump_linenum
  *
- * @param void
- * @return void
+ * @param linenum The line number to [attempt] jump to.
+ * @return Was the line found?
  */
 
-static void statement (void)
+static int jump_linenum (int linenum)
 {
-  int token;
-  char string[10];
-  token = tokenizer_token();
-  switch (token)
+  long to;
+  /* The jump may have been resolved ahead of time. */
+  if (line >= 0 && program->lines[line].target >= 0)
   {
-    /* REM statement (comment). */
-    case T_REM:
-      tokenizer_next();
-      accept(T_EOL);
-      break;
+    pc = (size_t) program->lines[line].target;
+    stats.jumps++;
+    return 1;
+  }
+  sample_phase = S_JUMP;
+  to = program_find(program, linenum);
+  sample_phase = S_STATEMENT;
+  /* If the search failed, linenum could not be found! */
+  if (to < 0)
+  {
+    dprintf(
+      "*warning: could not jump to `%d'\n",
+      E_WARNING, linenum);
+    return 0;
+  }
+  pc = (size_t) to;
+  stats.jumps++;
+  return 1;
+}
+
+/**
+ * goto_statement
+ *
+ * @param void
+ * @return void
+ */
+
+static void goto_statement (void)
+{
+  int to;
+  accept(T_GOTO);
+  to = token_num();
+  accept(T_NUMBER);
+  accept(T_EOL);
+  jump_linenum(to);
+}
+
+/**
+ * gosub_statement
+ *
+ * @param void
+ * @return void
+ */
+
+static void gosub_statement (void)
+{
+  int    to;
+  size_t back;
+  accept(T_GOSUB);
+  to = token_num();
+  accept(T_NUMBER);
+  accept(T_EOL);
+  if (return_count == VVTBI_RETURNS)
+    dprintf("*vvtbi.c: GOSUB nested deeper than %d\n",
+      E_ERROR, VVTBI_RETURNS);
+  /* RETURN resumes at the next line's token, found now. */
+  back = pc;
+  if (jump_linenum(to))
+    returns[return_count++] = back;
+}
+
+/**
+ * return_statement
+ *
+ * @param void
+ * @return void
+ */
+
+static void return_statement (void)
+{
+  accept(T_RETURN);
+  accept(T_EOL);
+  if (!return_count)
+    dprintf("*vvtbi.c: RETURN without GOSUB\n", E_ERROR);
+  pc = returns[--return_count];
+  stats.jumps++;
+}
+
+/**
+ * print_statement
+ *
+ * @param void
+ * @return void
+ */
+
+static void print_statement (void)
+{
+  sample_phase = S_OUTPUT;
+  accept(T_PRINT);
+  do {
+    /* Print a string literal. */
+    if (current_token() == T_STRING)
+    {
+      stats.printed += output_print("%s", token_string());
+      next_token();
+    }
+    /* A seperator, send a space. */
+    else if (current_token() == T_SEPERATOR)
+    {
+      stats.printed += output_print(" ");
+      next_token();
+    }
+    /* Evaluate and print an expression. */
+    else if (program->tokens[pc].flags & PROGRAM_TYPED)
+      stats.printed += print_value(typed_expression());
+    else if (current_token() == T_LETTER ||
+    current_token() == T_NUMBER ||
+    current_token() == T_LEFT_PAREN ||
+    current_token() == T_CALL)
+      stats.printed += output_print("%d", expression());
+    else
+    {
+      break;
+    }
+    /* This additionally ensures a new-line character
+       is present at the end of the line-statement. */
+    if (current_token() == T_EOF)
+      accept(T_EOL);
+  } while (current_token() != T_EOL &&
+    current_token() != T_EOF);
+
+  stats.printed += output_print("\n");
+  next_token();
+  sample_phase = S_STATEMENT;
+}
+
+/**
+ * if_statement
+ *
+ * @param void
+ * @return void
+ */
+
+static void if_statement (void)
+{
+  int r, to, typed;
+  typed = program->tokens[pc].flags & PROGRAM_TYPED;
+  accept(T_IF);
+  r = typed ? typed_relation() : relation();
+  accept(T_THEN);
+  to = token_num();
+  accept(T_NUMBER);
+  accept(T_EOL);
+  if (profile && line >= 0)
+  {
+    if (r)
+      profile[line].taken++;
+    else
+      profile[line].not_taken++;
+  }
+  if (r)
+    jump_linenum(to);
+}
+
+/**
+ * let_statement
+ *
+ * @param void
+ * @return void
+ */
+
+static void let_statement (void)
+{
+  int var, value, typed;
+  size_t place;
+  /* Flagged at load, if not an int expression to an int. */
+  typed = program->tokens[pc].flags & PROGRAM_TYPED;
+  /* An array element. */
+  if (program->tokens[pc + 1].token == T_LEFT_PAREN)
+  {
+    place = element();
+    accept(T_EQUAL);
+    arena[place] = typed ? (int) whole(typed_expression()) :
+      expression();
+    accept(T_EOL);
+    return;
+  }
+  var = token_variable();
+  accept(T_LETTER);
+  accept(T_EQUAL);
+  if (typed)
+  {
+    typed_store(var, typed_expression());
+    accept(T_EOL);
+    return;
+  }
+  value = expression();
+  set_variable(var, value);
+  if (tracing)
+    trace_variable(var, value);
+  accept(T_EOL);
+}
+
+/**
+ * store
+ *
+ * @param v The value to store, read by INPUT or READ.
+ * @return void
+ */
+
+static void store (struct value v)
+{
+  size_t place;
+  int    var;
+  if (program->tokens[pc + 1].token == T_LEFT_PAREN)
+  {
+    place = element();
+    arena[place] = (int) v.number;
+    return;
+  }
+  var = token_variable();
+  accept(T_LETTER);
+  typed_store(var, v);
+}
+
+/**
+ * input_statement
+ *
+ * @param void
+ * @return void
+ */
+
+static void input_statement (void)
+{
+  struct value v;
+  v.type = PROGRAM_WIDE;
+  accept(T_INPUT);
+  for (;;)
+  {
+    if (!input_number(&v.number))
+    {
+      dprintf(
+        "*warning: out of input\n",
+        E_WARNING);
+      v.number = 0;
+    }
+    store(v);
+    if (current_token() != T_SEPERATOR)
+      break;
+    next_token();
+  }
+  accept(T_EOL);
+}
+
+/**
+ * read_statement
+ *
+ * @param void
+ * @return void
+ */
+
+static void read_statement (void)
+{
+  struct value v;
+  v.type = PROGRAM_INTEGER;
+  accept(T_READ);
+  for (;;)
+  {
+    /* The DATA was packed when loaded. */
+    if (data < program->data_count)
+      v.number = program->data[data++];
+    else
+    {
+      dprintf(
+        "*warning: out of DATA\n",
+        E_WARNING);
+      v.number = 0;
+    }
+    store(v);
+    if (current_token() != T_SEPERATOR)
+      break;
+    next_token();
+  }
+  accept(T_EOL);
+}
+
+/**
+ * dim_statement
+ *
+ * @param void
+ * @return void
+ */
+
+static void dim_statement (void)
+{
+  const struct program_array *a;
+  accept(T_DIM);
+  for (;;)
+  {
+    /* The arena is laid out when loaded; DIM zeroes the array. */
+    a = &program->arrays[token_variable()];
+    accept(T_LETTER);
+    accept(T_LEFT_PAREN);
+    accept(T_NUMBER);
+    accept(T_RIGHT_PAREN);
+    memset(&arena[a->base], 0, a->length * sizeof *arena);
+    if (current_token() != T_SEPERATOR)
+      break;
+    next_token();
+  }
+  accept(T_EOL);
+}
+
+/**
+ * for_statement
+ *
+ * @param void
+ * @return void
+ */
+
+static void for_statement (void)
+{
+  struct value value;
+  long         limit, step;
+  int          var, i, typed;
+  typed = program->tokens[pc].flags & PROGRAM_TYPED;
+  accept(T_FOR);
+  var = token_variable();
+  accept(T_LETTER);
+  accept(T_EQUAL);
+  typed_store(var, operand(typed));
+  accept(T_TO);
+  /* The limit and step are evaluated once, in the variable's
+     type. */
+  limit = convert(operand(typed), program->types[var]);
+  value.type   = PROGRAM_INTEGER;
+  value.number = 1;
+  if (current_token() == T_STEP)
+  {
+    next_token();
+    value = operand(typed);
+  }
+  step = convert(value, program->types[var]);
+  accept(T_EOL);
+  /* A loop begun again, say by GOTO, ends any inside it. */
+  for (i = 0; i < loop_count && loops[i].variable != var; i++)
+    ;
+  if (i == VVTBI_LOOPS)
+    dprintf("*vvtbi.c: FOR nested deeper than %d\n",
+      E_ERROR, VVTBI_LOOPS);
+  loops[i].variable = var;
+  loops[i].typed    = typed;
+  loops[i].limit    = limit;
+  loops[i].step     = step;
+  /* The body begins at the next line; NEXT returns here
+     without a search. */
+  loops[i].body     = pc;
+  loop_count        = i + 1;
+}
+
+/**
+ * next_statement
+ *
+ * @param void
+ * @return void
+ */
+
+static void next_statement (void)
+{
+  struct vvtbi_loop *loop;
+  long               counter;
+  int                var;
+  accept(T_NEXT);
+  var = -1;
+  if (current_token() == T_LETTER)
+  {
+    var = token_variable();
+    accept(T_LETTER);
+  }
+  accept(T_EOL);
+  /* NEXT of an outer loop ends the loops inside it. */
+  while (loop_count && var >= 0 &&
+  loops[loop_count - 1].variable != var)
+    loop_count--;
+  if (!loop_count)
+    dprintf("*vvtbi.c: NEXT without FOR\n", E_ERROR);
+  loop = &loops[loop_count - 1];
+  if (loop->typed)
+    counter = wides[loop->variable] += loop->step;
+  else
+    counter = variables[loop->variable] += (int) loop->step;
+  if (tracing)
+    trace_variable(loop->variable, vvtbi_variable(loop->variable));
+  if (loop->step < 0 ?
+  counter >= loop->limit :
+  counter <= loop->limit)
+  {
+    pc = loop->body;
+    stats.jumps++;
+  }
+  else
+    loop_count--;
+}
+
+/**
+ * chain_statement
+ *
+ * @param void
+ * @return void
+ */
+
+static void chain_statement (void)
+{
+  struct program *next;
+  struct value    v;
+  int            *cells, *elements;
+  long           *numbers;
+  void           *block;
+  size_t          i, n;
+  int             from;
+
+  accept(T_CHAIN);
+  next = program_module(program, token_string());
+  accept(T_STRING);
+  /* Variables and arrays carry over by name, in the new
+     program's types; the rest begin at zero. */
+  cells    = allocate_cells(NULL, sizeof (int), 0, next->variable_count);
+  numbers  = allocate_cells(NULL, sizeof (long), 0, next->variable_count);
+  block    = NULL;
+  elements = allocate_arena(&block, next->arena_size);
+  for (i = 0; i < next->variable_count; i++)
+  {
+    from = program_variable(program, program_name(next, (int) i));
+    if (from < 0)
+      continue;
+    v.type   = program->types[from];
+    v.number = v.type == PROGRAM_INTEGER ? variables[from] : wides[from];
+    if (next->types[i] == PROGRAM_INTEGER)
+      cells[i]   = (int) whole(v);
+    else
+      numbers[i] = next->types[i] == PROGRAM_DECIMAL ?
+        convert(v, PROGRAM_DECIMAL) : whole(v);
+    n = program->arrays[from].length < next->arrays[i].length ?
+      program->arrays[from].length : next->arrays[i].length;
+    memcpy(&elements[next->arrays[i].base],
+      &arena[program->arrays[from].base], n * sizeof *arena);
+  }
+  /* The hooks and counts by line are told, while the program
+     run first is still held. */
+  if (chained)
+    chained(program, next);
+  /* The program run first owns the cells; the context, if any,
+     or vvtbi_init's. */
+  if (context)
+  {
+    program_release(context->program);
+    free(context->variables);
+    free(context->wides);
+    free(context->arena_block);
+    context->program        = next;
+    context->variables      = cells;
+    context->wides          = numbers;
+    context->variable_count = next->variable_count;
+    context->arena          = elements;
+    context->arena_block    = block;
+    context->arena_size     = next->arena_size;
+    resolve(context);
+    calls      = context->calls;
+    call_count = context->call_count;
+  }
+  else
+  {
+    program_release(loaded);
+    free(loaded_variables);
+    free(loaded_wides);
+    free(arena_block);
+    loaded           = next;
+    loaded_variables = cells;
+    loaded_wides     = numbers;
+    arena_block      = block;
+  }
+  program        = next;
+  variables      = cells;
+  wides          = numbers;
+  variable_count = next->variable_count;
+  arena          = elements;
+  pc             = 0;
+  line           = -1;
+  loop_count     = 0;
+  return_count   = 0;
+  data           = 0;
+}
+
+/**
+ * statement
+ *
+ * @param void
+ * @return void
+ */
+
+static void statement (void)
+{
+  int token;
+  char string[10];
+  token = current_token();
+  /* An assignment without LET counts as one. */
+  stats.statements[token == T_LETTER ? T_LET : token]++;
+  switch (token)
+  {
+    /* REM statement (comment). */
+    case T_REM:
+      next_token();
+      accept(T_EOL);
+      break;
     /* Print statement. */
     case T_PRINT:
       print_statement();
@@ -522,6 +1461,55 @@ static void statement (void)
     case T_GOTO:
       goto_statement();
       break;
+    /* Gosub statement. */
+    case T_GOSUB:
+      gosub_statement();
+      break;
+    /* Return statement. */
+    case T_RETURN:
+      return_statement();
+      break;
+    /* For statement. */
+    case T_FOR:
+      for_statement();
+      break;
+    /* Next statement. */
+    case T_NEXT:
+      next_statement();
+      break;
+    /* Dim statement. */
+    case T_DIM:
+      dim_statement();
+      break;
+    /* Call statement, its value unused. */
+    case T_CALL:
+      call();
+      accept(T_EOL);
+      break;
+    /* Include statement, merged when loaded. */
+    case T_INCLUDE:
+      next_token();
+      accept(T_STRING);
+      accept(T_EOL);
+      break;
+    /* Chain statement. */
+    case T_CHAIN:
+      chain_statement();
+      break;
+    /* Input statement. */
+    case T_INPUT:
+      input_statement();
+      break;
+    /* Read statement. */
+    case T_READ:
+      read_statement();
+      break;
+    /* Data statement, packed when loaded. */
+    case T_DATA:
+      while (current_token() != T_EOL && current_token() != T_EOF)
+        next_token();
+      accept(T_EOL);
+      break;
     /* Let statement. */
     case T_LET:
       accept(T_LET);
@@ -531,7 +1519,7 @@ static void statement (void)
       break;
     default:
     /* Unrecognized statement! */
-      to_string(string, sizeof string);
+      near(string, sizeof string);
       dprintf("*vvtbi.c: statement(): "
         "not implemented near `%s'\n",
         E_ERROR,
@@ -550,20 +1538,32 @@ static void statement (void)
 
 static void line_statement (void)
 {
-  int token;
+  int token, i;
   /* Skip irrelevant new-lines. */
-  if (tokenizer_token() == T_EOL)
+  if (current_token() == T_EOL)
   {
     do {
-      tokenizer_next();
-    } while (tokenizer_token() == T_EOL);
+      next_token();
+    } while (current_token() == T_EOL);
+  }
+  token = current_token();
+  line  = program->tokens[pc].line;
+  sample_line = line;
+  if (profile && line >= 0)
+    profile[line].count++;
+  if (hook_count)
+  {
+    for (i = 0; i < hook_count; i++)
+      hooks[i](line);
   }
-  token = tokenizer_token();
   /* Unless a comment, line number is mandatory. */
   if (token != T_REM)
   {
     accept(T_NUMBER);
   }
+  if (tracing)
+    trace_line(line >= 0 ? program->lines[line].number : -1,
+      current_token());
   statement();
 }
 
@@ -576,7 +1576,7 @@ static void line_statement (void)
 
 void vvtbi_run (void)
 {
-  if (tokenizer_finished())
+  if (vvtbi_finished())
     return;
   /* interpret line-statements! */
   line_statement();
@@ -592,5 +1592,580 @@ void vvtbi_run (void)
 int vvtbi_finished (void)
 {
   /* The interpreter is finished! */
-  return tokenizer_finished();
+  return current_token() == T_EOF;
+}
+
+/**
+ * vvtbi_program
+ *
+ * @param void
+ * @return program The running program.
+ */
+
+struct program *vvtbi_program (void)
+{
+  return program;
+}
+
+/**
+ * vvtbi_profile
+ *
+ * @param counts Counts to record into, indexed by line, or NULL.
+ * @return void
+ */
+
+void vvtbi_profile (struct profile_count *counts)
+{
+  profile = counts;
+}
+
+/**
+ * vvtbi_hook
+ *
+ * @param hook A function to call with the index of each line
+ *             (or -1) before it runs.
+ * @return Was there room for the hook?
+ */
+
+int vvtbi_hook (void (*hook) (int line))
+{
+  if (hook_count == VVTBI_HOOKS)
+    return 0;
+  hooks[hook_count++] = hook;
+  return 1;
+}
+
+/**
+ * vvtbi_unhook
+ *
+ * @param hook A function installed by vvtbi_hook.
+ * @return void
+ */
+
+void vvtbi_unhook (void (*hook) (int line))
+{
+  int i;
+  for (i = 0; i < hook_count; i++)
+    if (hooks[i] == hook)
+    {
+      /* Keep the remaining hooks in order. */
+      for (hook_count--; i < hook_count; i++)
+        hooks[i] = hooks[i + 1];
+      return;
+    }
+}
+
+/**
+ * vvtbi_chained
+ *
+ * @param hook A function to call with the program run and the
+ *             program CHAINed to, before the first is released;
+ *             the hooks and counts by line are kept across CHAIN.
+ * @return void
+ */
+
+void vvtbi_chained (void (*hook) (const struct program *from,
+  const struct program *to))
+{
+  chained = hook;
+}
+
+/**
+ * vvtbi_variable
+ *
+ * @param place Position in container.
+ * @return The variable's value in the running program.
+ */
+
+int vvtbi_variable (int place)
+{
+  struct value v;
+  if (place < 0 || (size_t) place >= variable_count ||
+  program->types[place] == PROGRAM_INTEGER)
+    return get_variable(place);
+  v.type   = program->types[place];
+  v.number = wides[place];
+  return (int) whole(v);
+}
+
+/**
+ * resolve
+ *
+ * @param ctx The context.
+ * @return void
+ */
+
+static void resolve (struct vvtbi_context *ctx)
+{
+  size_t i;
+  int    k;
+  ctx->call_count = ctx->program->function_count;
+  ctx->calls      = allocate_cells(ctx->calls, sizeof *ctx->calls, 0,
+    ctx->call_count);
+  /* Look each function up once, here, not at each CALL. */
+  for (i = 0; i < ctx->call_count; i++)
+  {
+    ctx->calls[i] = NULL;
+    for (k = 0; k < ctx->host_count; k++)
+      if (!strcmp(ctx->hosts[k].name,
+      program_function(ctx->program, (int) i)))
+        ctx->calls[i] = &ctx->hosts[k];
+  }
+}
+
+/**
+ * vvtbi_register
+ *
+ * @param ctx The context, initialized.
+ * @param name The name CALL gives the function.
+ * @param function The host function.
+ * @param arity The amount of arguments it takes.
+ * @return Was the function installed, or replaced? Names must
+ *         be names, and at most VVTBI_FUNCTIONS installed.
+ */
+
+int vvtbi_register (struct vvtbi_context *ctx, const char *name,
+  vvtbi_function function, int arity)
+{
+  int k;
+  if (strlen(name) > VVTBI_NAME_LENGTH || arity < 0 ||
+  arity > VVTBI_ARGUMENTS || !function)
+    return 0;
+  for (k = 0; k < ctx->host_count && strcmp(ctx->hosts[k].name, name);
+  k++)
+    ;
+  if (k == VVTBI_FUNCTIONS)
+    return 0;
+  if (k == ctx->host_count)
+    ctx->host_count++;
+  strcpy(ctx->hosts[k].name, name);
+  ctx->hosts[k].function = function;
+  ctx->hosts[k].arity    = arity;
+  resolve(ctx);
+  return 1;
+}
+
+/**
+ * vvtbi_context
+ *
+ * @param ctx The context to initialize.
+ * @param source Source code file.
+ * @return void
+ */
+
+void vvtbi_context (struct vvtbi_context *ctx, const char *source)
+{
+  /* Compile the source, or reuse it if cached. */
+  vvtbi_attach(ctx, program_load(source));
+}
+
+/**
+ * vvtbi_attach
+ *
+ * @param ctx The context to initialize.
+ * @param p A compiled program; the context takes over a reference.
+ * @return void
+ */
+
+void vvtbi_attach (struct vvtbi_context *ctx, struct program *p)
+{
+  ctx->program  = p;
+  ctx->pc       = 0;
+  ctx->finished = 0;
+  ctx->variable_count = p->variable_count;
+  ctx->variables    = allocate_cells(NULL, sizeof (int), 0,
+    ctx->variable_count);
+  ctx->wides        = allocate_cells(NULL, sizeof (long), 0,
+    ctx->variable_count);
+  ctx->arena_block  = NULL;
+  ctx->arena_size   = p->arena_size;
+  ctx->arena        = allocate_arena(&ctx->arena_block, ctx->arena_size);
+  ctx->loop_count   = 0;
+  ctx->return_count = 0;
+  ctx->data         = 0;
+  ctx->proofs       = 1;
+  ctx->host_count   = 0;
+  ctx->calls        = NULL;
+  resolve(ctx);
+}
+
+/**
+ * vvtbi_step
+ *
+ * @param ctx The context to resume.
+ * @param budget The maximum amount of line-statements to run.
+ * @return i The amount of line-statements run.
+ */
+
+int vvtbi_step (struct vvtbi_context *ctx, int budget)
+{
+  int i;
+  if (ctx->finished)
+    return 0;
+  /* Switch to the context... */
+  program = ctx->program;
+  pc      = ctx->pc;
+  /* A program edited since may have new variables, and have
+     grown its arrays. */
+  if (ctx->variable_count != program->variable_count)
+  {
+    ctx->variables      = allocate_cells(ctx->variables, sizeof (int),
+      ctx->variable_count, program->variable_count);
+    ctx->wides          = allocate_cells(ctx->wides, sizeof (long),
+      ctx->variable_count, program->variable_count);
+    ctx->variable_count = program->variable_count;
+  }
+  if (ctx->arena_size != program->arena_size)
+  {
+    ctx->arena_size = program->arena_size;
+    ctx->arena      = allocate_arena(&ctx->arena_block, ctx->arena_size);
+  }
+  /* And may call new functions. */
+  if (ctx->call_count != program->function_count)
+    resolve(ctx);
+  context        = ctx;
+  calls          = ctx->calls;
+  call_count     = ctx->call_count;
+  arena          = ctx->arena;
+  variables      = ctx->variables;
+  wides          = ctx->wides;
+  variable_count = ctx->variable_count;
+  memcpy(loops, ctx->loops, ctx->loop_count * sizeof *loops);
+  loop_count = ctx->loop_count;
+  memcpy(returns, ctx->returns, ctx->return_count * sizeof *returns);
+  return_count = ctx->return_count;
+  data         = ctx->data;
+  proofs       = ctx->proofs;
+  /* ...run line-statements until the budget is spent... */
+  for (i = 0; i < budget; i++)
+  {
+    if (vvtbi_finished())
+    {
+      ctx->finished = 1;
+      break;
+    }
+    line_statement();
+  }
+  /* ...and suspend it again. */
+  ctx->pc = pc;
+  memcpy(ctx->loops, loops, loop_count * sizeof *loops);
+  ctx->loop_count = loop_count;
+  memcpy(ctx->returns, returns, return_count * sizeof *returns);
+  ctx->return_count = return_count;
+  ctx->data         = data;
+  return i;
+}
+
+/**
+ * vvtbi_release
+ *
+ * @param ctx The context to release.
+ * @return void
+ */
+
+void vvtbi_release (struct vvtbi_context *ctx)
+{
+  if (ctx->program)
+    program_release(ctx->program);
+  free(ctx->variables);
+  free(ctx->wides);
+  free(ctx->arena_block);
+  free(ctx->calls);
+  ctx->calls       = NULL;
+  ctx->variables   = NULL;
+  ctx->wides       = NULL;
+  ctx->program     = NULL;
+  ctx->arena_block = NULL;
+  ctx->finished    = 1;
+}
+
+/**
+ * vvtbi_line
+ *
+ * @param ctx The context.
+ * @return The line number about to run, or -1.
+ */
+
+int vvtbi_line (const struct vvtbi_context *ctx)
+{
+  const struct program_token *t;
+  if (ctx->finished)
+    return -1;
+  /* Skip irrelevant new-lines. */
+  for (t = &ctx->program->tokens[ctx->pc]; t->token == T_EOL; t++)
+    ;
+  return t->token == T_NUMBER ? t->value : -1;
+}
+
+/**
+ * put_word
+ *
+ * @param out The stream to write to.
+ * @param word A 32-bit word, written little-endian.
+ * @return void
+ */
+
+static void put_word (FILE *out, unsigned long word)
+{
+  putc((int) (word & 0xff), out);
+  putc((int) ((word >> 8) & 0xff), out);
+  putc((int) ((word >> 16) & 0xff), out);
+  putc((int) ((word >> 24) & 0xff), out);
+}
+
+/**
+ * get_word
+ *
+ * @param in The stream to read from.
+ * @param word Destination of the 32-bit word.
+ * @return Was the word read whole?
+ */
+
+static int get_word (FILE *in, unsigned long *word)
+{
+  int i, c;
+  for (i = 0, *word = 0; i < 4; i++)
+  {
+    if ((c = getc(in)) == EOF)
+      return 0;
+    *word |= (unsigned long) c << (8 * i);
+  }
+  return 1;
+}
+
+/**
+ * to_int
+ *
+ * @param word A 32-bit word.
+ * @return The word, sign-extended.
+ */
+
+static int to_int (unsigned long word)
+{
+  return word & 0x80000000UL ?
+    (int) ((long) (word & 0x7fffffffUL) - 0x7fffffffL - 1) :
+    (int) word;
+}
+
+/**
+ * put_long
+ *
+ * @param out The stream to write to.
+ * @param number A 64-bit number, written as two words, low first.
+ * @return void
+ */
+
+static void put_long (FILE *out, long number)
+{
+  put_word(out, (unsigned long) number & 0xffffffffUL);
+  /* Shifted in halves: long may be only 32 bits. */
+  put_word(out, ((unsigned long) number >> 16 >> 16 & 0xffffffffUL) |
+    (number < 0 ? 0x80000000UL : 0));
+}
+
+/**
+ * get_long
+ *
+ * @param in The stream to read from.
+ * @param number Destination of the number.
+ * @return Was the number read whole?
+ */
+
+static int get_long (FILE *in, long *number)
+{
+  unsigned long low, high, word;
+  if (!get_word(in, &low) || !get_word(in, &high))
+    return 0;
+  word    = low | high << 16 << 16;
+  *number = high & 0x80000000UL ? -(long) ~word - 1 : (long) word;
+  return 1;
+}
+
+/**
+ * vvtbi_snapshot
+ *
+ * @param ctx The context, suspended at a line boundary.
+ * @param out The stream to write the snapshot to.
+ * @return Was the snapshot written?
+ */
+
+int vvtbi_snapshot (const struct vvtbi_context *ctx, FILE *out)
+{
+  size_t i;
+  /* Output so far belongs before the snapshot. */
+  output_flush();
+  fwrite(VVTBI_SNAPSHOT_MAGIC, 1, 4, out);
+  put_word(out, VVTBI_SNAPSHOT_VERSION);
+  /* The program is referenced by hash, not copied. */
+  put_word(out, ctx->program->hash);
+  put_word(out, (unsigned long) ctx->program->length);
+  put_word(out, (unsigned long) ctx->pc);
+  put_word(out, (unsigned long) ctx->variable_count);
+  /* An int a word, wide and decimal variables two. */
+  for (i = 0; i < ctx->variable_count; i++)
+    if (ctx->program->types[i] == PROGRAM_INTEGER)
+      put_word(out, (unsigned long) ctx->variables[i] & 0xffffffffUL);
+    else
+      put_long(out, ctx->wides[i]);
+  /* The FOR loops running. */
+  put_word(out, (unsigned long) ctx->loop_count);
+  for (i = 0; i < (size_t) ctx->loop_count; i++)
+  {
+    put_word(out, (unsigned long) ctx->loops[i].variable);
+    put_long(out, ctx->loops[i].limit);
+    put_long(out, ctx->loops[i].step);
+    put_word(out, (unsigned long) ctx->loops[i].body);
+  }
+  /* The GOSUBs to return from. */
+  put_word(out, (unsigned long) ctx->return_count);
+  for (i = 0; i < (size_t) ctx->return_count; i++)
+    put_word(out, (unsigned long) ctx->returns[i]);
+  /* The DATA item to READ next. */
+  put_word(out, (unsigned long) ctx->data);
+  /* The arrays. */
+  put_word(out, (unsigned long) ctx->arena_size);
+  for (i = 0; i < ctx->arena_size; i++)
+    put_word(out, (unsigned long) ctx->arena[i] & 0xffffffffUL);
+  return !ferror(out);
+}
+
+/**
+ * vvtbi_restore
+ *
+ * @param ctx The context, initialized from the snapshot's source.
+ * @param in The stream to read the snapshot from.
+ * @return Was the snapshot restored?
+ */
+
+int vvtbi_restore (struct vvtbi_context *ctx, FILE *in)
+{
+  char          magic[4];
+  unsigned long word[5], loop[2];
+  long          limit, step;
+  size_t        i, count;
+
+  if (fread(magic, 1, 4, in) != 4 ||
+  memcmp(magic, VVTBI_SNAPSHOT_MAGIC, 4))
+  {
+    dprintf("*vvtbi.c: not a snapshot\n", E_WARNING);
+    return 0;
+  }
+  for (i = 0; i < 5; i++)
+    if (!get_word(in, &word[i]))
+    {
+      dprintf("*vvtbi.c: snapshot is truncated\n", E_WARNING);
+      return 0;
+    }
+  /* Before version 5, variables were by letter, not slot. */
+  if (word[0] != VVTBI_SNAPSHOT_VERSION)
+  {
+    dprintf("*vvtbi.c: snapshot is version %lu, not %d\n",
+      E_WARNING, word[0], VVTBI_SNAPSHOT_VERSION);
+    return 0;
+  }
+  /* The snapshot must belong to this very program. */
+  if (word[1] != ctx->program->hash ||
+  word[2] != ctx->program->length ||
+  word[3] >= ctx->program->count ||
+  word[4] != ctx->variable_count)
+  {
+    dprintf("*vvtbi.c: snapshot does not match `%s'\n",
+      E_WARNING, ctx->program->file);
+    return 0;
+  }
+  for (i = 0; i < ctx->variable_count; i++)
+  {
+    if (ctx->program->types[i] == PROGRAM_INTEGER ?
+    !get_word(in, &loop[0]) : !get_long(in, &ctx->wides[i]))
+    {
+      dprintf("*vvtbi.c: snapshot is truncated\n", E_WARNING);
+      return 0;
+    }
+    if (ctx->program->types[i] == PROGRAM_INTEGER)
+      ctx->variables[i] = to_int(loop[0]);
+  }
+  if (!get_word(in, &loop[0]) || loop[0] > VVTBI_LOOPS)
+  {
+    dprintf("*vvtbi.c: snapshot is truncated\n", E_WARNING);
+    return 0;
+  }
+  count = (size_t) loop[0];
+  for (i = 0; i < count; i++)
+  {
+    if (!get_word(in, &loop[0]) || !get_long(in, &limit) ||
+    !get_long(in, &step) || !get_word(in, &loop[1]))
+    {
+      dprintf("*vvtbi.c: snapshot is truncated\n", E_WARNING);
+      return 0;
+    }
+    if (loop[0] >= ctx->variable_count || loop[1] >= ctx->program->count)
+    {
+      dprintf("*vvtbi.c: snapshot does not match `%s'\n",
+        E_WARNING, ctx->program->file);
+      return 0;
+    }
+    ctx->loops[i].variable = (int) loop[0];
+    ctx->loops[i].typed    =
+      ctx->program->types[loop[0]] != PROGRAM_INTEGER;
+    ctx->loops[i].limit    = limit;
+    ctx->loops[i].step     = step;
+    ctx->loops[i].body     = (size_t) loop[1];
+  }
+  ctx->loop_count = (int) count;
+  if (!get_word(in, &loop[0]) || loop[0] > VVTBI_RETURNS)
+  {
+    dprintf("*vvtbi.c: snapshot is truncated\n", E_WARNING);
+    return 0;
+  }
+  count = (size_t) loop[0];
+  for (i = 0; i < count; i++)
+  {
+    if (!get_word(in, &loop[0]) || loop[0] >= ctx->program->count)
+    {
+      dprintf("*vvtbi.c: snapshot does not match `%s'\n",
+        E_WARNING, ctx->program->file);
+      return 0;
+    }
+    ctx->returns[i] = (size_t) loop[0];
+  }
+  ctx->return_count = (int) count;
+  if (!get_word(in, &loop[0]))
+  {
+    dprintf("*vvtbi.c: snapshot is truncated\n", E_WARNING);
+    return 0;
+  }
+  if (loop[0] > ctx->program->data_count)
+  {
+    dprintf("*vvtbi.c: snapshot does not match `%s'\n",
+      E_WARNING, ctx->program->file);
+    return 0;
+  }
+  ctx->data = (size_t) loop[0];
+  if (!get_word(in, &loop[0]))
+  {
+    dprintf("*vvtbi.c: snapshot is truncated\n", E_WARNING);
+    return 0;
+  }
+  if (loop[0] != ctx->arena_size)
+  {
+    dprintf("*vvtbi.c: snapshot does not match `%s'\n",
+      E_WARNING, ctx->program->file);
+    return 0;
+  }
+  for (i = 0; i < ctx->arena_size; i++)
+  {
+    if (!get_word(in, &loop[0]))
+    {
+      dprintf("*vvtbi.c: snapshot is truncated\n", E_WARNING);
+      return 0;
+    }
+    ctx->arena[i] = to_int(loop[0]);
+  }
+  ctx->pc           = (size_t) word[3];
+  ctx->finished     = 0;
+  /* Its values, loops' included, may lie outside the ranges
+     proven from the program's start: check every index and
+     divisor. */
+  ctx->proofs       = 0;
+  return 1;
 }
\ No newline at end of file
@@ -8,9 +8,93 @@
 #ifndef _VVTBI_H__
 #define _VVTBI_H__
 
+#include "config.h"
+#include "program.h"
+#include "profile.h"
+
+/* The snapshot file format, see vvtbi_snapshot. */
+#define VVTBI_SNAPSHOT_MAGIC   "VVTS"
+#define VVTBI_SNAPSHOT_VERSION 7
+
+/* A FOR loop running: its variable, whether it is wide or
+   decimal, limit and step, in the variable's type, and the
+   index of the token its body begins at. */
+struct vvtbi_loop {
+  int    variable;
+  int    typed;
+  long   limit;
+  long   step;
+  size_t body;
+};
+
+struct vvtbi_context;
+
+/* A host function, run by CALL with the context calling and its
+   arguments, in order; it gives the CALL's value. The
+   arguments are the caller's, so one function may serve any
+   number of contexts. */
+typedef int (*vvtbi_function) (struct vvtbi_context *ctx,
+                               const int *args);
+
+/* A host function installed by vvtbi_register. */
+struct vvtbi_host {
+  char           name[VVTBI_NAME_LENGTH + 1];
+  vvtbi_function function;
+  int            arity;
+};
+
+/* A suspended interpreter, resumed with vvtbi_step. It has
+   variable_count variables, by slot, in variables if int and
+   in wides if not; its arrays are arena_size
+   elements, aligned within arena_block. data is the index of
+   the DATA item to READ next. calls holds, for each of the
+   program's call_count functions, its host, or NULL. proofs
+   tells if the indexes and divisors proven safe at load may go
+   unchecked: not once restored, as a snapshot's values were
+   never proven. */
+struct vvtbi_context {
+  struct program   *program;
+  size_t            pc;
+  int              *variables;
+  long             *wides;
+  size_t            variable_count;
+  int              *arena;
+  void             *arena_block;
+  size_t            arena_size;
+  struct vvtbi_loop loops[VVTBI_LOOPS];
+  int               loop_count;
+  size_t            returns[VVTBI_RETURNS];
+  int               return_count;
+  size_t            data;
+  struct vvtbi_host hosts[VVTBI_FUNCTIONS];
+  int               host_count;
+  const struct vvtbi_host
+                  **calls;
+  size_t            call_count;
+  int               proofs;
+  int               finished;
+};
+
 void        vvtbi_init     (const char *source);
 void        vvtbi_run      (void);
 const char *vvtbi_token    (int token);
 int         vvtbi_finished (void);
+struct program
+           *vvtbi_program  (void);
+void        vvtbi_profile  (struct profile_count *counts);
+int         vvtbi_hook     (void (*hook) (int line));
+void        vvtbi_unhook   (void (*hook) (int line));
+void        vvtbi_chained  (void (*hook) (const struct program *from,
+                            const struct program *to));
+int         vvtbi_variable (int place);
+void        vvtbi_context  (struct vvtbi_context *ctx, const char *source);
+void        vvtbi_attach   (struct vvtbi_context *ctx, struct program *p);
+int         vvtbi_step     (struct vvtbi_context *ctx, int budget);
+void        vvtbi_release  (struct vvtbi_context *ctx);
+int         vvtbi_line     (const struct vvtbi_context *ctx);
+int         vvtbi_snapshot (const struct vvtbi_context *ctx, FILE *out);
+int         vvtbi_restore  (struct vvtbi_context *ctx, FILE *in);
+int         vvtbi_register (struct vvtbi_context *ctx, const char *name,
+                            vvtbi_function function, int arity);
 
 #endif /* _VVTBI_H__ */
\ No newline at end of file
@@ -0,0 +1,88 @@
+/***********************************
+   host.c, @format.new-line  lf
+           @format.use-tabs  false
+   @format.tab-size    2
+   @format.indent-size 2
+   @format.line-length 80
+************************************/
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "config.h"
+#include "program.h"
+#include "vvtbi.h"
+
+/* The CALLs of count made so far. */
+static int counted = 0;
+
+/******************************************************************************/
+
+/**
+ * twice
+ *
+ * @param ctx The context calling.
+ * @param args Its argument.
+ * @return The argument, doubled.
+ */
+
+static int twice (struct vvtbi_context *ctx, const int *args)
+{
+  (void) ctx;
+  return args[0] * 2;
+}
+
+/**
+ * digits
+ *
+ * @param ctx The context calling.
+ * @param args Its three arguments, each a digit.
+ * @return The digits, in the order passed.
+ */
+
+static int digits (struct vvtbi_context *ctx, const int *args)
+{
+  (void) ctx;
+  return args[0] * 100 + args[1] * 10 + args[2];
+}
+
+/**
+ * count
+ *
+ * @param ctx The context calling.
+ * @param args None.
+ * @return The CALLs of count so far, this one included.
+ */
+
+static int count (struct vvtbi_context *ctx, const int *args)
+{
+  (void) ctx;
+  (void) args;
+  return ++counted;
+}
+
+/******************/
+/* Start program. */
+/******************/
+
+int main (int argc, char **argv)
+{
+  struct vvtbi_context ctx;
+
+  if (argc != 2)
+  {
+    fprintf(stderr, "Usage: %s file.vvtb\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  /* The functions run by tests/host*.vvtb, registered once the
+     program is loaded. */
+  vvtbi_context(&ctx, argv[1]);
+  if (!vvtbi_register(&ctx, "twice", twice, 1) ||
+  !vvtbi_register(&ctx, "digits", digits, 3) ||
+  !vvtbi_register(&ctx, "count", count, 0))
+    return EXIT_FAILURE;
+  while (!ctx.finished)
+    vvtbi_step(&ctx, VVTBI_SCHEDULER_BUDGET);
+  vvtbi_release(&ctx);
+  fflush(stdout);
+  return EXIT_SUCCESS;
+}
\ No newline at end of file